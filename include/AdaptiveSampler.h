@@ -0,0 +1,78 @@
+#ifndef ADAPTIVE_SAMPLER_H
+#define ADAPTIVE_SAMPLER_H
+
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <vector>
+#include "QuantumNumbers.h"
+#include "SamplerOptions.h"
+
+struct HybridSet;
+
+// When a cloud has enough points: every bound is a 95% confidence half-width
+struct AdaptiveTarget {
+    double histogramError = 0.02; // of any radial bin, relative to the fullest bin
+    double momentError = 0.005;   // of <r> and <r^2>, relative to the value
+    int bins = 64;                // radial histogram over the sampling radius
+    size_t minPoints = 20000;
+    size_t maxPoints = 20000000;
+};
+
+struct AdaptiveResult {
+    size_t points = 0;
+    int rounds = 0;
+    long long trials = 0;
+    double meanR = 0.0;
+    double meanRError = 0.0; // 95% half-widths
+    double meanR2 = 0.0;
+    double meanR2Error = 0.0;
+    double histogramError = 0.0; // relative to the fullest bin, as in AdaptiveTarget
+    bool converged = false;      // false when maxPoints stopped it first
+    float ms = 0.0f;
+};
+
+// Running estimates of the distance from the nucleus over a growing cloud. Bins hold the
+// fraction of points in each shell of the histogram; the error of a bin is the binomial one.
+class RadialStatistics {
+public:
+    RadialStatistics(double maxR, int bins);
+    void add(const glm::vec3* points, size_t count);
+
+    size_t getCount() const { return count_; }
+    double getMeanR() const;
+    double getMeanRError() const;
+    double getMeanR2() const;
+    double getMeanR2Error() const;
+    double getHistogramError() const;
+    double getBin(int i) const { return count_ > 0 ? (double)bins_[i] / count_ : 0.0; }
+    int getBinCount() const { return (int)bins_.size(); }
+
+    bool meets(const AdaptiveTarget& target) const;
+    // Points the cloud needs to meet target, extrapolated from the 1/sqrt(N) falloff of
+    // every half-width
+    size_t pointsFor(const AdaptiveTarget& target) const;
+
+private:
+    double maxR_;
+    std::vector<size_t> bins_;
+    size_t count_ = 0;
+    double sumR_ = 0.0;
+    double sumR2_ = 0.0;
+    double sumR4_ = 0.0;
+};
+
+// Grows a cloud in rounds until its radial statistics meet the target, so a compact state
+// stops early and a diffuse one keeps going. Round k is a complete sampler run seeded with
+// Random::derive(options.seed, k), appended to the points before it, so the result is
+// reproducible and, like the samplers' own output, any prefix is an unbiased subsample.
+// Each round is sized from the points the statistics still ask for and the acceptance rate
+// seen so far.
+class AdaptiveSampler {
+public:
+    static AdaptiveResult sample(const QuantumNumbers& qn, std::vector<glm::vec3>& points, std::vector<glm::vec3>& colors, const AdaptiveTarget& target,
+                                 int maxThreads = 0, const SamplerOptions& options = SamplerOptions());
+    static AdaptiveResult sample(const HybridSet& set, std::vector<glm::vec3>& points, std::vector<glm::vec3>& colors, const AdaptiveTarget& target,
+                                 int maxThreads = 0, uint64_t seed = Random::DEFAULT_SEED);
+};
+
+#endif // ADAPTIVE_SAMPLER_H
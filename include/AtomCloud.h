@@ -0,0 +1,70 @@
+#ifndef ATOM_CLOUD_H
+#define ATOM_CLOUD_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <map>
+#include <utility>
+#include <vector>
+#include <demoShaderLoader.h>
+#include "ElectronConfiguration.h"
+#include "Random.h"
+
+// Combined cloud of every occupied subshell of an atom. Each subshell is sampled as its
+// hydrogenic (n, l) orbitals with charge 1 and scaled by 1/Zeff when packed, since
+// psi_Z(r) = Z^(3/2) psi_1(Zr). A partly filled subshell spreads its electrons evenly
+// over m, the spherical average.
+//
+// Samples are cached per (n, l) and m, so a new configuration only samples the points
+// it is missing and a screening change costs a repack. All subshells share one buffer at
+// per-subshell offsets and are drawn with a single glMultiDrawArrays.
+class AtomCloud {
+public:
+    bool init();
+    void clear();
+
+    // pointBudget is split over the subshells in proportion to their occupancy. Every
+    // sampling round of an (n, l, m) set is seeded from seed, the state and the points it
+    // already holds, so the same sequence of updates gives the same cloud. A new seed drops
+    // the cache.
+    void update(const std::vector<Subshell>& configuration, int nuclearCharge, int pointBudget, uint64_t seed = Random::DEFAULT_SEED);
+
+    // fraction scales every subshell's point count, as in OrbitalComparison::draw
+    void draw(const glm::mat4& model, float fraction, float pointSize, float alpha);
+
+    const std::vector<Subshell>& getConfiguration() const { return configuration_; }
+    int getSubshellPoints(int i) const { return (int)count_[i]; }
+    static glm::vec3 subshellColor(int n, int l);
+    int getTotalPoints() const { return totalPoints_; }
+    float getCloudRadius() const { return cloudRadius_; } // RMS distance from the nucleus
+    int getLastSampledJobs() const { return lastSampledJobs_; } // (subshell, m) sets topped up by the last update
+    float getLastUpdateMs() const { return lastUpdateMs_; }
+    uint64_t getSeed() const { return seed_; }
+
+private:
+    // unit charge samples of one subshell, one set per m = -l..l
+    typedef std::vector<std::vector<glm::vec3>> SubshellSamples;
+    std::map<std::pair<int, int>, SubshellSamples> cache_;
+
+    Shader shader_;
+    GLint modelLoc_ = -1;
+    GLint pointSizeLoc_ = -1;
+    GLint alphaLoc_ = -1;
+
+    GLuint vao_ = 0;
+    GLuint positionVBO_ = 0;
+    GLuint colorVBO_ = 0;
+
+    std::vector<Subshell> configuration_;
+    std::vector<GLint> first_;
+    std::vector<GLsizei> count_;
+    std::vector<GLsizei> drawCount_;
+    int totalPoints_ = 0;
+    float cloudRadius_ = 0.0f;
+    int lastSampledJobs_ = 0;
+    float lastUpdateMs_ = 0.0f;
+    uint64_t seed_ = Random::DEFAULT_SEED;
+};
+
+#endif // ATOM_CLOUD_H
@@ -0,0 +1,44 @@
+#ifndef DENSITY_RENDERER_H
+#define DENSITY_RENDERER_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <demoShaderLoader.h>
+
+// Splats points additively into a float target (no depth test, no sorting, so the result
+// does not depend on draw order) and resolves it with an exposure tone mapping pass.
+class DensityRenderer {
+public:
+    bool init();
+    void clear();
+
+    // Draws the cloud into the accumulation target and blends the tone mapped result
+    // over the currently bound framebuffer.
+    void render(GLuint vao, GLsizei count, int width, int height, const glm::mat4& model, float exposure);
+
+    // Progressive refinement: each call adds one more batch of points to the target instead
+    // of clearing it (a resize or resetAccumulation starts over), resolve shows the running
+    // average of all batches so far.
+    void accumulate(GLuint vao, GLsizei count, int width, int height, const glm::mat4& model);
+    void resolve(float exposure);
+    void resetAccumulation() { frames_ = 0; }
+    int getAccumulatedFrames() const { return frames_; }
+
+private:
+    void resize(int width, int height);
+
+    Shader splatShader_;
+    Shader tonemapShader_;
+    GLint splatModelLoc_ = -1;
+    GLint pointSizeLoc_ = -1;
+    GLint pointWeightLoc_ = -1;
+    GLint exposureLoc_ = -1;
+    GLuint fbo_ = 0;
+    GLuint accumulationTexture_ = 0;
+    GLuint emptyVAO_ = 0;
+    int width_ = 0;
+    int height_ = 0;
+    int frames_ = 0;
+};
+
+#endif // DENSITY_RENDERER_H
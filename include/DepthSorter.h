@@ -0,0 +1,66 @@
+#ifndef DEPTH_SORTER_H
+#define DEPTH_SORTER_H
+
+#include <glm/glm.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Back-to-front ordering of the point cloud for alpha blending. Sorting runs on its own
+// thread and produces an index order, the render loop keeps drawing with the last finished
+// order so a sort never blocks a frame.
+//
+// A sort first re-keys the previous order for the new view. Small camera moves leave it
+// nearly sorted and a bounded insertion sort finishes it; otherwise a multi-threaded LSD
+// radix sort on 16 bit quantized view depth rebuilds it from scratch.
+class DepthSorter {
+public:
+    DepthSorter();
+    ~DepthSorter();
+
+    // Copies the positions, previous orders become invalid
+    void setPoints(const std::vector<glm::vec3>& points);
+    // Sorts the first count points (the LOD prefix). Newest request wins, requests made
+    // while a sort runs are picked up afterwards
+    void requestSort(const glm::mat4& modelView, size_t count);
+    // Swaps a finished order into indices, false if nothing new is ready
+    bool fetchOrder(std::vector<unsigned int>& indices);
+
+    float getLastSortMs() const { return lastSortMs_; }
+    bool getLastSortIncremental() const { return lastSortIncremental_; }
+
+private:
+    void run();
+    void sort(const glm::mat4& modelView, size_t count);
+    bool insertionSort(size_t maxMoves);
+    void radixSort(int threadCount);
+
+    std::vector<glm::vec3> points_;
+    float radius_ = 0.0f;
+    std::vector<unsigned int> order_;   // owned by the sort thread
+    std::vector<uint16_t> keys_;
+    std::vector<unsigned int> tmpOrder_;
+    std::vector<uint16_t> tmpKeys_;
+
+    std::vector<unsigned int> finished_;
+    bool finishedReady_ = false;
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    glm::mat4 requestedView_;
+    size_t requestedCount_ = 0;
+    bool requested_ = false;
+    bool pointsChanged_ = false;
+    std::vector<glm::vec3> newPoints_;
+    bool stop_ = false;
+    unsigned int generation_ = 0;
+
+    std::atomic<float> lastSortMs_;
+    std::atomic<bool> lastSortIncremental_;
+    std::thread thread_;
+};
+
+#endif // DEPTH_SORTER_H
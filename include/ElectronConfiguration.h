@@ -0,0 +1,41 @@
+#ifndef ELECTRON_CONFIGURATION_H
+#define ELECTRON_CONFIGURATION_H
+
+#include <string>
+#include <vector>
+
+struct Subshell {
+    int n;
+    int l;
+    int electrons;
+    double zeff; // effective nuclear charge seen by one of its electrons
+
+    Subshell(int n_val = 1, int l_val = 0, int electrons_val = 1)
+        : n(n_val), l(l_val), electrons(electrons_val), zeff(1.0) {}
+};
+
+// Parsing, Aufbau filling and Slater screening. Only shells the Hydrogen class
+// evaluates (n <= 4) can be occupied, which makes krypton the heaviest full atom.
+class ElectronConfiguration {
+public:
+    static const int MAX_N = 4;
+    static const int MAX_ELECTRONS = 36;
+
+    static int capacity(int l) { return 2 * (2 * l + 1); }
+    static char letter(int l);
+
+    // Ground state by Madelung order: 1s 2s 2p 3s 3p 4s 3d 4p
+    static std::vector<Subshell> aufbau(int electrons);
+
+    // Accepts "1s2 2s2 2p6 3s1", superscript counts ("1s² 2s¹"), "2p^6" and a noble gas
+    // core such as "[Ne] 3s1". Returns false with a message on malformed input.
+    static bool parse(const std::string& text, std::vector<Subshell>& configuration, std::string& error);
+    static std::string format(const std::vector<Subshell>& configuration);
+
+    static int electronCount(const std::vector<Subshell>& configuration);
+
+    // Fills in zeff for every subshell by Slater's rules around a nucleus of charge Z
+    static void applyScreening(std::vector<Subshell>& configuration, int Z);
+};
+
+#endif // ELECTRON_CONFIGURATION_H
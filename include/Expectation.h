@@ -0,0 +1,51 @@
+#ifndef EXPECTATION_H
+#define EXPECTATION_H
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include "QuantumNumbers.h"
+
+// Integrals over |psi|^2 of one state, lengths in Bohr radii for Z = 1 and a fixed nucleus
+// like the samplers. Values are not divided by the norm, so a normalization error shows up.
+struct StateExpectation {
+    double norm = 0.0;
+    double meanR = 0.0;
+    double meanR2 = 0.0;
+    double meanInvR = 0.0;
+    double samplingRadius = 0.0; // holds all but Expectation::SAMPLING_TAIL of the probability
+    float ms = 0.0f;
+};
+
+// Gauss-Laguerre in r against the e^(-2r/n) of R^2, Gauss-Legendre in cos(theta) and the
+// trapezoid rule in phi. Each is exact for its factor of |psi|^2 times a low order polynomial,
+// so the moments of r are exact up to rounding; other integrands converge fast if smooth.
+class Expectation {
+public:
+    static const double SAMPLING_TAIL;
+
+    // computed once per (n, l, |m|) and shared, safe to call from any thread
+    static std::shared_ptr<const StateExpectation> get(const QuantumNumbers& qn);
+    static std::shared_ptr<const StateExpectation> compute(const QuantumNumbers& qn);
+
+    // <f> for any f(r, theta, phi), the radial nodes split over up to maxThreads cores (0 = all)
+    static double evaluate(const QuantumNumbers& qn, const std::function<double(double, double, double)>& f, int maxThreads = 0);
+
+    // Probability beyond radius: with r = radius + t the integrand is still a polynomial times
+    // e^(-2t/n), so the same Gauss-Laguerre rule integrates it exactly.
+    static double tail(int n, int l, double radius);
+
+    // closed forms
+    static double analyticMeanR(int n, int l) { return (3.0 * n * n - l * (l + 1)) / 2.0; }
+    static double analyticMeanR2(int n, int l) { return n * n * (5.0 * n * n + 1.0 - 3.0 * l * (l + 1)) / 2.0; }
+    static double analyticMeanInvR(int n) { return 1.0 / (n * n); }
+
+private:
+    typedef std::tuple<int, int, int> Key;
+    static std::mutex cacheMutex_;
+    static std::map<Key, std::shared_ptr<const StateExpectation>> cache_;
+};
+
+#endif // EXPECTATION_H
@@ -0,0 +1,58 @@
+#ifndef FRAME_CAPTURE_H
+#define FRAME_CAPTURE_H
+
+#include <glad/glad.h>
+#include <string>
+#include "FrameWriter.h"
+
+// Screenshot / recording from the default framebuffer without stalling the GPU.
+// glReadPixels goes into a ring of PBOs, each guarded by a fence, and a slot is only
+// mapped once its fence has signaled (a few frames later). If every slot is still in
+// flight the frame is dropped instead of waiting.
+class FrameCapture {
+public:
+    static const int RING_SIZE = 3;
+
+    FrameCapture();
+
+    void requestScreenshot();
+    void startRecording();
+    void stopRecording();
+    bool isRecording() const { return recording_; }
+
+    // Call after the scene is drawn and before the UI, so the UI is not captured
+    void capture(int width, int height);
+    void clear();
+
+    FrameWriter& getWriter() { return writer_; }
+    int getPendingReadbacks() const { return pending_; }
+    size_t getFramesCaptured() const { return framesCaptured_; }
+    size_t getFramesDropped() const { return ringDrops_ + writer_.getFramesDropped(); }
+    const std::string& getLastPath() const { return lastPath_; }
+
+private:
+    struct Slot {
+        GLuint pbo = 0;
+        GLsync fence = 0;
+        int width = 0;
+        int height = 0;
+        std::string path;
+    };
+
+    void collect();
+
+    Slot slots_[RING_SIZE];
+    int head_ = 0;    // next slot to read into
+    int pending_ = 0; // slots waiting for their fence, oldest is head_ - pending_
+    bool screenshotRequested_ = false;
+    bool recording_ = false;
+    std::string recordingDir_;
+    int recordingFrame_ = 0;
+    int screenshotCount_ = 0; // keeps screenshots taken within one second apart
+    size_t framesCaptured_ = 0;
+    size_t ringDrops_ = 0;
+    std::string lastPath_;
+    FrameWriter writer_;
+};
+
+#endif // FRAME_CAPTURE_H
@@ -0,0 +1,66 @@
+#ifndef FRAME_GOVERNOR_H
+#define FRAME_GOVERNOR_H
+
+#include <glad/glad.h>
+#include <chrono>
+
+// Holds a frame time target by stepping through a ladder of quality levels, each a
+// fraction of the LOD point count and an internal render resolution. CPU time is the
+// work between beginFrame and endFrame (vsync waits excluded), GPU time comes from
+// timestamp queries read back a few frames later.
+//
+// Hysteresis: a level only drops after the smoothed frame time stayed above 110% of the
+// target for a while, and only rises after a much longer stretch below 75%. After each
+// change the measurements of frames still in flight are ignored.
+class FrameGovernor {
+public:
+    static const int QUERY_COUNT = 4;
+
+    struct Level {
+        float pointScale;  // multiplies the LOD point count
+        float renderScale; // internal resolution relative to the window
+    };
+
+    bool init();
+    void clear();
+
+    void beginFrame();
+    void endFrame();
+
+    void setTargetMs(float targetMs) { targetMs_ = targetMs; }
+    void reset();
+
+    const Level& getLevel() const;
+    int getLevelIndex() const { return level_; }
+    int getLevelCount() const;
+    int getNativeLevel() const;
+    float getCpuMs() const { return cpuMs_; }
+    float getGpuMs() const { return gpuMs_; }
+    float getSmoothedMs() const { return smoothedMs_; }
+
+private:
+    void collect();
+    void adjust();
+
+    struct Query {
+        GLuint begin = 0;
+        GLuint end = 0;
+        bool pending = false;
+    };
+
+    Query queries_[QUERY_COUNT];
+    int head_ = 0;
+    bool gpuTiming_ = false;
+    std::chrono::steady_clock::time_point cpuStart_;
+
+    float targetMs_ = 16.6f;
+    float cpuMs_ = 0.0f;
+    float gpuMs_ = 0.0f;
+    float smoothedMs_ = 0.0f;
+    int level_ = 0;
+    int overFrames_ = 0;
+    int underFrames_ = 0;
+    int cooldown_ = 0;
+};
+
+#endif // FRAME_GOVERNOR_H
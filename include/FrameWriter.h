@@ -0,0 +1,61 @@
+#ifndef FRAME_WRITER_H
+#define FRAME_WRITER_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+enum class FrameFormat { PNG, Raw };
+
+struct Frame {
+    std::string path; // without extension, the writer appends .png / .raw
+    int width = 0;
+    int height = 0;
+    std::vector<unsigned char> pixels; // RGBA8, bottom-up rows as returned by glReadPixels
+};
+
+// Encodes frames on background threads so the render loop never touches the disk.
+class FrameWriter {
+public:
+    explicit FrameWriter(FrameFormat format = FrameFormat::PNG, size_t maxQueued = 64, int encoderThreads = 1);
+    ~FrameWriter();
+
+    // Blocks while the queue is full (batch rendering, nothing may be lost)
+    void push(Frame frame);
+    // Drops the frame instead of blocking (interactive capture)
+    bool tryPush(Frame frame);
+    // Waits until every queued frame is on disk
+    void flush();
+
+    // Reuses a pixel buffer released by the encoder to avoid reallocating every frame
+    std::vector<unsigned char> acquireBuffer(size_t size);
+
+    void setFormat(FrameFormat format);
+    FrameFormat getFormat() const;
+    size_t getQueueDepth() const;
+    size_t getFramesWritten() const;
+    size_t getFramesDropped() const;
+    size_t getMaxQueued() const { return maxQueued_; }
+
+private:
+    void run();
+    void encode(Frame& frame, FrameFormat format);
+
+    FrameFormat format_;
+    size_t maxQueued_;
+    std::deque<Frame> queue_;
+    std::vector<std::vector<unsigned char>> freeBuffers_;
+    mutable std::mutex mutex_;
+    std::condition_variable queueChanged_;
+    size_t framesWritten_ = 0;
+    size_t framesDropped_ = 0;
+    int busy_ = 0;
+    bool stop_ = false;
+    std::vector<std::thread> threads_;
+};
+
+#endif // FRAME_WRITER_H
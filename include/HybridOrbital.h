@@ -0,0 +1,49 @@
+#ifndef HYBRID_ORBITAL_H
+#define HYBRID_ORBITAL_H
+
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+#include "Random.h"
+#include "RenderSettings.h"
+
+// Real orbital of a shell: m > 0 takes cos(m phi), m < 0 sin(|m| phi), so (1, 1) is p_x,
+// (1, -1) p_y and (1, 0) p_z. The radial part is signed so its outermost lobe is positive,
+// then hybrid coefficients point the big lobes the way chemistry tables do for every n.
+struct RealOrbital {
+    int l;
+    int m;
+};
+
+// Hybrids of one shell, row h of the coefficients mixes the basis orbitals into hybrid h
+struct HybridSet {
+    int n = 2;
+    std::vector<RealOrbital> basis;
+    std::vector<std::vector<double>> coefficients;
+
+    int getHybridCount() const { return (int)coefficients.size(); }
+};
+
+class HybridOrbital {
+public:
+    static const char* name(HybridType type);
+    // false if shell n lacks the orbitals (sp sets need n >= 2, dsp3 n >= 3)
+    static bool preset(HybridType type, int n, HybridSet& set);
+
+    // psi[i * hybrids + h] of every hybrid at every point. Radial, polar and azimuthal factors
+    // are computed once per point and shared by the whole set, so four sp3 hybrids cost about
+    // one orbital evaluation plus a small matrix product.
+    static void evaluate(const HybridSet& set, const glm::vec3* points, size_t count, double* psi);
+
+    // The hybrid densities do not factor into R(r) Theta(theta), so unlike sampleOrbital this
+    // draws r from a bound on the set's shared radial profile and a uniform direction, then
+    // gives every hybrid its own acceptance test on the shared evaluation. Points are colored
+    // by hybrid and, as in sampleOrbital, any prefix is an unbiased subsample. Seeded like the
+    // chunks of sampleOrbital: chunk c draws after c + 1 long jumps, the bounds need no draws.
+    static void sample(const HybridSet& set, std::vector<glm::vec3>& points, std::vector<glm::vec3>& colors, int trials = 50000, int maxThreads = 0,
+                       uint64_t seed = Random::DEFAULT_SEED);
+
+    static glm::vec3 hybridColor(int h);
+};
+
+#endif // HYBRID_ORBITAL_H
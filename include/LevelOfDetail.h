@@ -0,0 +1,20 @@
+#ifndef LEVEL_OF_DETAIL_H
+#define LEVEL_OF_DETAIL_H
+
+// Picks how many points of the cloud to draw. The sampler emits points in random order,
+// so drawing a prefix of the buffer is an unbiased subsample of the whole cloud.
+struct LodSelection {
+    int drawCount;
+    float pointSize;
+    float alpha;
+};
+
+class LevelOfDetail {
+public:
+    // cloudRadius and distance in world units, fovY in radians. budgetScale caps the count
+    // at a fraction of the cloud (set by the frame governor).
+    LodSelection select(int totalPoints, float cloudRadius, float distance, float fovY, int viewportHeight,
+                        float pointsPerPixel, float basePointSize, float baseAlpha, float budgetScale = 1.0f) const;
+};
+
+#endif // LEVEL_OF_DETAIL_H
@@ -0,0 +1,67 @@
+#ifndef LOOKUP_TABLE_H
+#define LOOKUP_TABLE_H
+
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <vector>
+#include "QuantumNumbers.h"
+
+// Clamped cubic spline of a smooth function on [lo, hi] over uniform knots. build() doubles
+// the knot count until the spline stays within maxError * max|f| of the function, checked
+// between the knots. Segments are four floats, 16 byte aligned, so a lookup is one index
+// computation and a Horner step on a single cache line.
+class LookupTable {
+public:
+    static const int MAX_SEGMENTS = 1 << 16;
+
+    // false if even MAX_SEGMENTS cannot reach maxError, the table is still usable
+    bool build(const std::function<double(double)>& f, double lo, double hi, double maxError);
+
+    float operator()(double x) const {
+        double t = (x - lo_) * invStep_;
+        int i = std::min(std::max((int)t, 0), last_);
+        float u = (float)(t - i);
+        const Segment& s = segments_[i];
+        return s.a + u * (s.b + u * (s.c + u * s.d));
+    }
+
+    int getSegmentCount() const { return (int)segments_.size(); }
+    size_t getBytes() const { return segments_.size() * sizeof(Segment); }
+    double getMeasuredError() const { return measuredError_; } // relative to max|f|
+
+private:
+    struct alignas(16) Segment {
+        float a, b, c, d; // in u = (x - x_i) / step
+    };
+
+    void fit(const std::function<double(double)>& f, int segments);
+
+    std::vector<Segment> segments_;
+    double lo_ = 0.0;
+    double invStep_ = 0.0;
+    int last_ = 0;
+    double measuredError_ = 0.0;
+};
+
+// R_nl on [0, maxR] and Theta_lm on [0, pi] for one state, built once per state and error
+// bound and shared by every sampling thread
+class OrbitalTables {
+public:
+    LookupTable radial;
+    LookupTable polar;
+    double buildMs = 0.0;
+
+    static std::shared_ptr<const OrbitalTables> build(const QuantumNumbers& qn, double maxR, double maxError);
+    static std::shared_ptr<const OrbitalTables> get(const QuantumNumbers& qn, double maxR, double maxError);
+
+private:
+    typedef std::tuple<int, int, int, double, double> Key;
+    static std::mutex cacheMutex_;
+    static std::map<Key, std::shared_ptr<const OrbitalTables>> cache_;
+};
+
+#endif // LOOKUP_TABLE_H
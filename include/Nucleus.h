@@ -0,0 +1,19 @@
+#ifndef NUCLEUS_H
+#define NUCLEUS_H
+
+// Charge and reduced mass of a one-electron system. Its states are the hydrogen states
+// (Z = 1, infinitely heavy nucleus) stretched by lengthScale() and renormalized, so a
+// cloud sampled once at unit scale serves every Z and mass.
+struct Nucleus {
+    double Z = 1.0;
+    double reducedMass = 1.0; // of the orbiting particle, in electron masses
+
+    double lengthScale() const { return 1.0 / (Z * reducedMass); } // in Bohr radii
+
+    // masses in electron masses
+    static double reducedMassOf(double particleMass, double nucleusMass) {
+        return particleMass * nucleusMass / (particleMass + nucleusMass);
+    }
+};
+
+#endif // NUCLEUS_H
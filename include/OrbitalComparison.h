@@ -0,0 +1,59 @@
+#ifndef ORBITAL_COMPARISON_H
+#define ORBITAL_COMPARISON_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <vector>
+#include <demoShaderLoader.h>
+#include "QuantumNumbers.h"
+#include "RenderSettings.h"
+
+// Several orbitals side by side in one draw. All point sets live in one buffer at
+// per-orbital offsets and are drawn with a single glMultiDrawArrays; each vertex carries
+// its orbital index, which picks the orbital's placement from a uniform array (GL 3.3 has
+// no gl_DrawID).
+class OrbitalComparison {
+public:
+    static const int MAX_ORBITALS = 64; // matches comparison.vert
+
+    bool init();
+    void clear();
+
+    static std::vector<QuantumNumbers> statesFor(ComparisonMode mode, const QuantumNumbers& qn);
+
+    // Samples every state in parallel (one state per core) and uploads them as one buffer.
+    // State i is seeded with Random::derive(options.seed, i).
+    void generate(const std::vector<QuantumNumbers>& states, int trials, const SamplerOptions& options = SamplerOptions());
+    void setLayout(ComparisonLayout layout);
+
+    // fraction scales every orbital's point count (each set is in random order, so a prefix
+    // is an unbiased subsample)
+    void draw(const glm::mat4& model, float fraction, float pointSize, float alpha);
+
+    int getOrbitalCount() const { return (int)first_.size(); }
+    int getTotalPoints() const { return totalPoints_; }
+    float getExtent() const { return extent_; } // radius of the whole arrangement
+
+private:
+    Shader shader_;
+    GLint modelLoc_ = -1;
+    GLint placementsLoc_ = -1;
+    GLint pointSizeLoc_ = -1;
+    GLint alphaLoc_ = -1;
+
+    GLuint vao_ = 0;
+    GLuint positionVBO_ = 0;
+    GLuint colorVBO_ = 0;
+    GLuint orbitalVBO_ = 0;
+
+    std::vector<GLint> first_;
+    std::vector<GLsizei> count_;
+    std::vector<GLsizei> drawCount_;
+    std::vector<float> radius_;
+    std::vector<glm::vec4> placements_;
+    ComparisonLayout layout_ = ComparisonLayout::Grid;
+    int totalPoints_ = 0;
+    float extent_ = 0.0f;
+};
+
+#endif // ORBITAL_COMPARISON_H
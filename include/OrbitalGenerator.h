@@ -3,21 +3,80 @@
 
 #include <glm/glm.hpp>
 #include <vector>
+#include "AdaptiveSampler.h"
+#include "HybridOrbital.h"
 #include "QuantumNumbers.h"
+#include "SamplerOptions.h"
 
 class OrbitalGenerator {
 public:
     OrbitalGenerator(unsigned int orbitalVAO, unsigned int orbitalPosVBO, unsigned int orbitalColorVBO);
-    void generateOrbital(const QuantumNumbers& qn);
+    void generateOrbital(const QuantumNumbers& qn); // sample() followed by upload()
+    void sample(const QuantumNumbers& qn);
+    void sampleHybrid(const HybridSet& set); // one cloud, colored by hybrid
+    void upload();
     int getNumOrbitalPoints() const { return numOrbitalPoints_; }
+    const std::vector<glm::vec3>& getOrbitalPoints() const { return orbitalPoints_; }
+    float getCloudRadius() const { return cloudRadius_; } // RMS distance from the nucleus
+    void setTrials(int trials) { trials_ = trials; }
+    int getTrials() const { return trials_; }
+    void setSamplerOptions(const SamplerOptions& options) { options_ = options; }
+    // sample() and sampleHybrid() grow the cloud until it meets target instead of running the trial count
+    void setAdaptive(bool enabled, const AdaptiveTarget& target = AdaptiveTarget()) {
+        adaptive_ = enabled;
+        adaptiveTarget_ = target;
+    }
+    const AdaptiveResult& getAdaptiveResult() const { return adaptiveResult_; } // of the last adaptive sample
+
+    // CPU-only rejection sampling, safe to call from any thread. Large trial counts are
+    // split into chunks that run on up to maxThreads cores (0 = all).
+    // Points are independent draws kept in generation order, so any prefix of the result is an
+    // unbiased subsample (the LOD draws prefixes). Keep it that way when changing the sampler.
+    // Points are for Z = 1 and a fixed nucleus, other nuclei scale them by Nucleus::lengthScale().
+    //
+    // Stream layout, for reproducible clouds: Random(options.seed) first draws the 10000 r and
+    // then the 10000 theta of the scan that starts the max density search. Trials are then split into chunks of 65536,
+    // and chunk c draws from that generator after c + 1 long jumps: per block of 256
+    // candidates, r, theta, phi and the acceptance uniforms, then one spin coin per accepted
+    // point when s == 0. Chunks are concatenated in order. The result does not depend on
+    // maxThreads, and Random and VectorMath give the same bits on every SIMD width.
+    // Candidates are drawn within this radius, which leaves out Expectation::SAMPLING_TAIL of
+    // the probability (see Expectation::tail)
+    static double samplingRadius(const QuantumNumbers& qn);
+    static void sampleOrbital(const QuantumNumbers& qn, std::vector<glm::vec3>& points, std::vector<glm::vec3>& colors, int trials = 50000, int maxThreads = 0,
+                              const SamplerOptions& options = SamplerOptions());
+
+    // Exact against table and vector evaluators on one thread: the density kernels alone over
+    // the same candidates, and the whole sampler
+    struct EvaluatorBenchmark {
+        float exactKernelMs = 0.0f;
+        float tableKernelMs = 0.0f;
+        float vectorKernelMs = 0.0f;
+        float exactSampleMs = 0.0f;
+        float tableSampleMs = 0.0f;
+        float vectorSampleMs = 0.0f;
+        float buildMs = 0.0f;
+        int tableSegments = 0;
+        float tableError = 0.0f;
+        double kernelSum = 0.0; // of every kernel's densities, so none of the timed loops is dead code
+    };
+    static EvaluatorBenchmark benchmarkEvaluators(const QuantumNumbers& qn, int trials, double tableError, MathAccuracy accuracy = MathAccuracy::Precise);
 
 private:
+    void updateCloudRadius();
+
     unsigned int orbitalVAO_;
     unsigned int orbitalPosVBO_;
     unsigned int orbitalColorVBO_;
     std::vector<glm::vec3> orbitalPoints_;
     std::vector<glm::vec3> orbitalColors_;
     int numOrbitalPoints_;
+    int trials_;
+    SamplerOptions options_;
+    bool adaptive_ = false;
+    AdaptiveTarget adaptiveTarget_;
+    AdaptiveResult adaptiveResult_;
+    float cloudRadius_;
 };
 
 #endif // ORBITAL_GENERATOR_H
@@ -0,0 +1,89 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <glad/glad.h>
+#include "Trace.h"
+#include <chrono>
+#include <string>
+#include <vector>
+
+// Per-stage CPU timers and GL_TIME_ELAPSED queries for the main loop, with a rolling
+// history of the last HISTORY frames. Each stage owns two queries used on alternate
+// frames, a result is read one frame later and dropped if the GPU has not got there yet,
+// so reading never stalls. GPU stages must not nest (GL allows one elapsed query at a
+// time), CPU-only stages may.
+class Profiler {
+public:
+    static const int HISTORY = 240;
+
+    struct Stage {
+        std::string name;
+        bool gpu = false;
+        float cpuMs[HISTORY];
+        float gpuMs[HISTORY];
+        GLuint queries[2] = {0, 0};
+        long long queryFrame[2] = {-1, -1}; // frame the query measured, -1 when not in flight
+        std::chrono::steady_clock::time_point cpuStart;
+        int depth = 0;
+        bool ownsQuery = false;
+    };
+
+    struct Percentiles {
+        float p50 = 0.0f;
+        float p95 = 0.0f;
+        float p99 = 0.0f;
+    };
+
+    void beginFrame();
+    void endFrame();
+
+    void begin(const char* name, bool gpu = true);
+    void end(const char* name);
+
+    void setEnabled(bool enabled) { enabled_ = enabled; }
+    bool isEnabled() const { return enabled_; }
+    void clear();
+
+    const std::vector<Stage>& getStages() const { return stages_; }
+    const float* getFrameMs() const { return frameMs_; }
+    long long getFrameIndex() const { return frame_; }
+    // oldest first, missing samples (stage skipped that frame) read as 0
+    void getHistory(const float* ring, float* out) const;
+    Percentiles getPercentiles(const float* ring) const;
+
+    // Writes the history as one row per frame, returns false if the file cannot be opened
+    bool exportCsv(const std::string& path) const;
+    // Timestamped file under captures/, returns the path or an empty string on failure
+    std::string exportCsv() const;
+
+private:
+    Stage& findStage(const char* name, bool gpu);
+    void collect(Stage& stage, int set);
+
+    std::vector<Stage> stages_;
+    float frameMs_[HISTORY];
+    long long frame_ = -1;
+    std::chrono::steady_clock::time_point frameStart_;
+    bool enabled_ = true;
+    bool gpuActive_ = false;
+};
+
+// Times the enclosing block as one profiler stage, and as a trace event when tracing is built in
+class ProfileScope {
+public:
+    ProfileScope(Profiler& profiler, const char* name, bool gpu = true)
+        : profiler_(profiler), name_(name) {
+        TRACE_BEGIN(name);
+        profiler_.begin(name, gpu);
+    }
+    ~ProfileScope() {
+        profiler_.end(name_);
+        TRACE_END();
+    }
+
+private:
+    Profiler& profiler_;
+    const char* name_;
+};
+
+#endif // PROFILER_H
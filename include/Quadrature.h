@@ -0,0 +1,17 @@
+#ifndef QUADRATURE_H
+#define QUADRATURE_H
+
+#include <vector>
+
+// Gauss rules: sum w[i] f(x[i]) is exact for polynomials f of degree up to 2 count - 1
+namespace Quadrature {
+
+// integral of f(x) e^(-x) over [0, inf). Weights of the outermost nodes underflow to 0 past
+// count ~ 100, where their share is far below double precision anyway.
+void gaussLaguerre(int count, std::vector<double>& x, std::vector<double>& w);
+// integral of f(x) over [-1, 1]
+void gaussLegendre(int count, std::vector<double>& x, std::vector<double>& w);
+
+} // namespace Quadrature
+
+#endif // QUADRATURE_H
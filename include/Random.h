@@ -0,0 +1,36 @@
+#ifndef RANDOM_H
+#define RANDOM_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Eight interleaved xoshiro128+ generators for bulk uniform floats. The lanes are one
+// sequence 2^64 steps apart, output k comes from lane k % LANES, so the stream is the same
+// whatever Simd::WIDTH the build uses and however the calls to fill() are split up.
+// longJump() skips 2^96 steps, far past all eight lanes, which gives up to 2^32
+// non-overlapping streams for parallel work: copy the generator, then longJump() the original.
+class Random {
+public:
+    static const int LANES = 8;
+    static const uint64_t DEFAULT_SEED = 1;
+
+    explicit Random(uint64_t seed = DEFAULT_SEED);
+    // Seed of sub-request index of a seeded request (a batch, a state of a set), hashed so
+    // neighbouring indices give unrelated streams
+    static uint64_t derive(uint64_t seed, uint64_t index);
+
+    void fill(float* out, size_t count); // uniform in [0, 1), 23 bits
+    float next();
+    void jump();     // 2^64 steps of every lane
+    void longJump(); // 2^96 steps of every lane
+
+private:
+    void step(float* out, size_t steps); // steps * LANES outputs
+    void jumpLanes(const uint32_t* polynomial);
+
+    alignas(32) uint32_t state_[4][LANES];
+    float buffer_[LANES];
+    int buffered_ = 0; // unread outputs at the end of buffer_
+};
+
+#endif // RANDOM_H
@@ -0,0 +1,37 @@
+#ifndef REDRAW_SCHEDULER_H
+#define REDRAW_SCHEDULER_H
+
+// Decides whether the main loop has to draw another frame. Anything that changes the image
+// invalidates it with a reason and a number of frames; when nothing is pending the loop
+// sleeps in glfwWaitEventsTimeout instead of redrawing the same picture at vsync.
+class RedrawScheduler {
+public:
+    enum Reason : unsigned {
+        Camera = 1u << 0,
+        Orbital = 1u << 1,
+        Interface = 1u << 2,   // input reached ImGui, hover and widget states need a few frames
+        Animation = 1u << 3,   // recording, readbacks in flight
+        Progressive = 1u << 4, // work that improves the image until it converges
+        Window = 1u << 5       // resize, expose
+    };
+
+    void invalidate(unsigned reasons, int frames = 1);
+    bool needsRedraw() const { return framesLeft_ > 0; }
+
+    // call at the start of each drawn frame, returns the reasons it is drawn for.
+    // Invalidations made while drawing it ask for the frames after it.
+    unsigned beginFrame();
+
+    unsigned getLastReasons() const { return lastReasons_; }
+    unsigned long long getFramesRendered() const { return framesRendered_; }
+
+    static const char* reasonName(Reason reason);
+
+private:
+    int framesLeft_ = 1;
+    unsigned pendingReasons_ = Window;
+    unsigned lastReasons_ = 0;
+    unsigned long long framesRendered_ = 0;
+};
+
+#endif // REDRAW_SCHEDULER_H
@@ -0,0 +1,90 @@
+#ifndef RENDER_SETTINGS_H
+#define RENDER_SETTINGS_H
+
+#include <vector>
+#include "AdaptiveSampler.h"
+#include "ElectronConfiguration.h"
+#include "SamplerOptions.h"
+
+enum class RenderMode {
+    Points,  // opaque depth tested points
+    Density  // additive HDR splats resolved by a tone mapping pass
+};
+
+enum class ComparisonMode {
+    Off,
+    Subshell, // every m of the selected n, l
+    Shell     // every l, m of the selected n
+};
+
+enum class ComparisonLayout {
+    Grid,
+    Overlay
+};
+
+enum class HybridType {
+    None,
+    SP,
+    SP2,
+    SP3,
+    DSP3 // trigonal bipyramid from s, p and d_z2
+};
+
+struct RenderSettings {
+    RenderMode mode = RenderMode::Points;
+    float exposure = 1.0f;
+    bool progressive = true;     // density mode keeps adding fresh samples while the camera is still
+    int progressiveFrames = 64;  // batches averaged before the image counts as converged
+    float pointAlpha = 1.0f; // below 1 the points are depth sorted and blended
+    int trials = 50000;
+    bool adaptive = false; // sample until the radial statistics meet adaptiveTarget, trials is ignored
+    AdaptiveTarget adaptiveTarget;
+    SamplerOptions sampler;
+    bool trueScale = true; // ions and exotic atoms at their real size, off keeps hydrogen's size
+
+    ComparisonMode comparison = ComparisonMode::Off;
+    ComparisonLayout comparisonLayout = ComparisonLayout::Grid;
+    HybridType hybrid = HybridType::None; // replaces the single orbital with a hybrid set of its shell
+
+    bool lodEnabled = true;
+    float lodPointsPerPixel = 2.0f; // drawn points per covered pixel
+
+    bool idleRedraw = true; // only draw when something changed, sleep in between
+    bool adaptiveQuality = true; // frame governor trades points and resolution for frame time
+    float frameBudgetMs = 16.6f;
+};
+
+// Whole atom view, replaces the single orbital and the comparison while enabled
+struct AtomSettings {
+    bool enabled = false;
+    int electrons = 11;
+    int pointBudget = 500000; // shared by all subshells in proportion to occupancy
+    std::vector<Subshell> configuration = ElectronConfiguration::aufbau(11);
+};
+
+// What the renderer ended up doing last frame, shown in the UI
+struct RenderStats {
+    int drawnPoints = 0;
+    int totalPoints = 0;
+    float pointSize = 2.0f;
+    int renderWidth = 0;
+    int renderHeight = 0;
+    int accumulatedFrames = 0;
+    int comparedOrbitals = 0;
+    int hybridCount = 0; // hybrids in the shown cloud, 0 for a plain orbital
+    AdaptiveResult adaptive; // of the shown cloud when RenderSettings::adaptive is on
+    unsigned long long framesRendered = 0;
+    unsigned redrawReasons = 0; // RedrawScheduler::Reason bits of the last frame
+
+    float cpuMs = 0.0f;
+    float gpuMs = 0.0f;
+    int qualityLevel = 0;
+    int qualityLevelCount = 0;
+    float pointScale = 1.0f;
+    float renderScale = 1.0f;
+
+    float lastSortMs = 0.0f;
+    bool lastSortIncremental = false;
+};
+
+#endif // RENDER_SETTINGS_H
@@ -0,0 +1,26 @@
+#ifndef RENDER_TARGET_H
+#define RENDER_TARGET_H
+
+#include <glad/glad.h>
+
+// Offscreen color + depth target, used to render the scene at a different resolution
+// than the window and scale it back up (or down) with a blit.
+class RenderTarget {
+public:
+    void resize(int width, int height);
+    void bind();
+    void blitToDefault(int width, int height);
+    void clear();
+
+    int getWidth() const { return width_; }
+    int getHeight() const { return height_; }
+
+private:
+    GLuint fbo_ = 0;
+    GLuint color_ = 0;
+    GLuint depth_ = 0;
+    int width_ = 0;
+    int height_ = 0;
+};
+
+#endif // RENDER_TARGET_H
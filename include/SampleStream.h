@@ -0,0 +1,50 @@
+#ifndef SAMPLE_STREAM_H
+#define SAMPLE_STREAM_H
+
+#include <glm/glm.hpp>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "HybridOrbital.h"
+#include "QuantumNumbers.h"
+#include "SamplerOptions.h"
+
+// Keeps one batch of freshly sampled points ready on a background thread, for progressive
+// refinement. Only one batch is produced ahead, the thread sleeps until it is taken, so a
+// converged (or moving) view costs no sampling.
+class SampleStream {
+public:
+    SampleStream();
+    ~SampleStream();
+
+    // Batches of the previous state are discarded. Batch k (from 0) of a source is seeded
+    // with Random::derive(seed, k + 1), the resident cloud sampled with seed itself is not
+    // drawn again.
+    void setSource(const QuantumNumbers& qn, int trials, const SamplerOptions& options = SamplerOptions());
+    void setSource(const HybridSet& set, int trials, uint64_t seed = Random::DEFAULT_SEED);
+    // Swaps a ready batch in, false if the next one is still being sampled
+    bool fetch(std::vector<glm::vec3>& points, std::vector<glm::vec3>& colors);
+
+private:
+    void run();
+
+    std::vector<glm::vec3> readyPoints_;
+    std::vector<glm::vec3> readyColors_;
+    bool ready_ = false;
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    QuantumNumbers qn_;
+    SamplerOptions options_;
+    HybridSet hybrid_;
+    bool isHybrid_ = false;
+    int trials_ = 0;
+    bool hasSource_ = false;
+    bool stop_ = false;
+    unsigned int generation_ = 0;
+    uint64_t batch_ = 0; // batches sampled of the current source
+    std::thread thread_;
+};
+
+#endif // SAMPLE_STREAM_H
@@ -0,0 +1,22 @@
+#ifndef SAMPLER_OPTIONS_H
+#define SAMPLER_OPTIONS_H
+
+#include <cstdint>
+#include "Random.h"
+#include "VectorMath.h"
+
+enum class OrbitalEvaluator {
+    Exact, // Hydrogen::getR and getTheta per candidate
+    Table, // cubic spline tables of R and Theta, see OrbitalTables
+    Vector // batched Hydrogen::getR and getTheta on VectorMath
+};
+
+// How the rejection sampler evaluates and draws its candidates
+struct SamplerOptions {
+    OrbitalEvaluator evaluator = OrbitalEvaluator::Exact;
+    double tableError = 1e-4; // largest table error relative to the function's peak
+    MathAccuracy accuracy = MathAccuracy::Precise; // Vector evaluator and the Cartesian transform
+    uint64_t seed = Random::DEFAULT_SEED; // same seed and options, same points
+};
+
+#endif // SAMPLER_OPTIONS_H
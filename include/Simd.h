@@ -0,0 +1,150 @@
+#ifndef SIMD_H
+#define SIMD_H
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+// Thin wrapper over the widest vector unit the compiler targets: AVX2 (8 lanes) when built
+// with -mavx2, SSE2 (4 lanes, every x86-64 target) otherwise, one scalar lane elsewhere.
+// Only the operations the vector math and RNG kernels need are here, and every one of them
+// rounds the same way on every width, so results do not depend on which one was picked.
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define HYDROGEN_SIMD_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define HYDROGEN_SIMD_SSE2
+#endif
+
+namespace Simd {
+
+#if defined(HYDROGEN_SIMD_AVX2)
+
+const int WIDTH = 8;
+inline const char* name() { return "AVX2"; }
+
+struct Float { __m256 v; };
+struct Int { __m256i v; };
+
+inline Float set(float x) { return {_mm256_set1_ps(x)}; }
+inline Int set(int32_t x) { return {_mm256_set1_epi32(x)}; }
+inline Float load(const float* p) { return {_mm256_loadu_ps(p)}; }
+inline void store(float* p, Float a) { _mm256_storeu_ps(p, a.v); }
+inline Int load(const uint32_t* p) { return {_mm256_loadu_si256((const __m256i*)p)}; }
+inline void store(uint32_t* p, Int a) { _mm256_storeu_si256((__m256i*)p, a.v); }
+
+inline Float operator+(Float a, Float b) { return {_mm256_add_ps(a.v, b.v)}; }
+inline Float operator-(Float a, Float b) { return {_mm256_sub_ps(a.v, b.v)}; }
+inline Float operator*(Float a, Float b) { return {_mm256_mul_ps(a.v, b.v)}; }
+inline Float operator/(Float a, Float b) { return {_mm256_div_ps(a.v, b.v)}; }
+inline Float min(Float a, Float b) { return {_mm256_min_ps(a.v, b.v)}; }
+inline Float max(Float a, Float b) { return {_mm256_max_ps(a.v, b.v)}; }
+inline Float sqrt(Float a) { return {_mm256_sqrt_ps(a.v)}; }
+inline Float operator<(Float a, Float b) { return {_mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ)}; }
+inline Float operator&(Float a, Float b) { return {_mm256_and_ps(a.v, b.v)}; }
+inline Float operator^(Float a, Float b) { return {_mm256_xor_ps(a.v, b.v)}; }
+inline Float select(Float mask, Float a, Float b) { return {_mm256_blendv_ps(b.v, a.v, mask.v)}; }
+
+inline Int operator+(Int a, Int b) { return {_mm256_add_epi32(a.v, b.v)}; }
+inline Int operator-(Int a, Int b) { return {_mm256_sub_epi32(a.v, b.v)}; }
+inline Int operator&(Int a, Int b) { return {_mm256_and_si256(a.v, b.v)}; }
+inline Int operator|(Int a, Int b) { return {_mm256_or_si256(a.v, b.v)}; }
+inline Int operator^(Int a, Int b) { return {_mm256_xor_si256(a.v, b.v)}; }
+inline Int operator<<(Int a, int n) { return {_mm256_slli_epi32(a.v, n)}; }
+inline Int shiftRight(Int a, int n) { return {_mm256_srli_epi32(a.v, n)}; } // logical
+inline Int operator==(Int a, Int b) { return {_mm256_cmpeq_epi32(a.v, b.v)}; }
+
+inline Int roundToInt(Float a) { return {_mm256_cvtps_epi32(a.v)}; } // to nearest even
+inline Float toFloat(Int a) { return {_mm256_cvtepi32_ps(a.v)}; }
+inline Int asInt(Float a) { return {_mm256_castps_si256(a.v)}; }
+inline Float asFloat(Int a) { return {_mm256_castsi256_ps(a.v)}; }
+
+#elif defined(HYDROGEN_SIMD_SSE2)
+
+const int WIDTH = 4;
+inline const char* name() { return "SSE2"; }
+
+struct Float { __m128 v; };
+struct Int { __m128i v; };
+
+inline Float set(float x) { return {_mm_set1_ps(x)}; }
+inline Int set(int32_t x) { return {_mm_set1_epi32(x)}; }
+inline Float load(const float* p) { return {_mm_loadu_ps(p)}; }
+inline void store(float* p, Float a) { _mm_storeu_ps(p, a.v); }
+inline Int load(const uint32_t* p) { return {_mm_loadu_si128((const __m128i*)p)}; }
+inline void store(uint32_t* p, Int a) { _mm_storeu_si128((__m128i*)p, a.v); }
+
+inline Float operator+(Float a, Float b) { return {_mm_add_ps(a.v, b.v)}; }
+inline Float operator-(Float a, Float b) { return {_mm_sub_ps(a.v, b.v)}; }
+inline Float operator*(Float a, Float b) { return {_mm_mul_ps(a.v, b.v)}; }
+inline Float operator/(Float a, Float b) { return {_mm_div_ps(a.v, b.v)}; }
+inline Float min(Float a, Float b) { return {_mm_min_ps(a.v, b.v)}; }
+inline Float max(Float a, Float b) { return {_mm_max_ps(a.v, b.v)}; }
+inline Float sqrt(Float a) { return {_mm_sqrt_ps(a.v)}; }
+inline Float operator<(Float a, Float b) { return {_mm_cmplt_ps(a.v, b.v)}; }
+inline Float operator&(Float a, Float b) { return {_mm_and_ps(a.v, b.v)}; }
+inline Float operator^(Float a, Float b) { return {_mm_xor_ps(a.v, b.v)}; }
+inline Float select(Float mask, Float a, Float b) { return {_mm_or_ps(_mm_and_ps(mask.v, a.v), _mm_andnot_ps(mask.v, b.v))}; }
+
+inline Int operator+(Int a, Int b) { return {_mm_add_epi32(a.v, b.v)}; }
+inline Int operator-(Int a, Int b) { return {_mm_sub_epi32(a.v, b.v)}; }
+inline Int operator&(Int a, Int b) { return {_mm_and_si128(a.v, b.v)}; }
+inline Int operator|(Int a, Int b) { return {_mm_or_si128(a.v, b.v)}; }
+inline Int operator^(Int a, Int b) { return {_mm_xor_si128(a.v, b.v)}; }
+inline Int operator<<(Int a, int n) { return {_mm_slli_epi32(a.v, n)}; }
+inline Int shiftRight(Int a, int n) { return {_mm_srli_epi32(a.v, n)}; }
+inline Int operator==(Int a, Int b) { return {_mm_cmpeq_epi32(a.v, b.v)}; }
+
+inline Int roundToInt(Float a) { return {_mm_cvtps_epi32(a.v)}; }
+inline Float toFloat(Int a) { return {_mm_cvtepi32_ps(a.v)}; }
+inline Int asInt(Float a) { return {_mm_castps_si128(a.v)}; }
+inline Float asFloat(Int a) { return {_mm_castsi128_ps(a.v)}; }
+
+#else
+
+const int WIDTH = 1;
+inline const char* name() { return "scalar"; }
+
+struct Float { float v; };
+struct Int { int32_t v; };
+
+inline Float set(float x) { return {x}; }
+inline Int set(int32_t x) { return {x}; }
+inline Float load(const float* p) { return {*p}; }
+inline void store(float* p, Float a) { *p = a.v; }
+inline Int load(const uint32_t* p) { return {(int32_t)*p}; }
+inline void store(uint32_t* p, Int a) { *p = (uint32_t)a.v; }
+
+inline Int asInt(Float a) { Int r; std::memcpy(&r.v, &a.v, 4); return r; }
+inline Float asFloat(Int a) { Float r; std::memcpy(&r.v, &a.v, 4); return r; }
+
+inline Float operator+(Float a, Float b) { return {a.v + b.v}; }
+inline Float operator-(Float a, Float b) { return {a.v - b.v}; }
+inline Float operator*(Float a, Float b) { return {a.v * b.v}; }
+inline Float operator/(Float a, Float b) { return {a.v / b.v}; }
+inline Float min(Float a, Float b) { return {a.v < b.v ? a.v : b.v}; } // NaN handling as minps
+inline Float max(Float a, Float b) { return {a.v > b.v ? a.v : b.v}; }
+inline Float sqrt(Float a) { return {std::sqrt(a.v)}; }
+inline Float operator<(Float a, Float b) { return asFloat({a.v < b.v ? -1 : 0}); }
+inline Float operator&(Float a, Float b) { return asFloat({asInt(a).v & asInt(b).v}); }
+inline Float operator^(Float a, Float b) { return asFloat({asInt(a).v ^ asInt(b).v}); }
+inline Float select(Float mask, Float a, Float b) { return asInt(mask).v ? a : b; }
+
+inline Int operator+(Int a, Int b) { return {(int32_t)((uint32_t)a.v + (uint32_t)b.v)}; }
+inline Int operator-(Int a, Int b) { return {(int32_t)((uint32_t)a.v - (uint32_t)b.v)}; }
+inline Int operator&(Int a, Int b) { return {a.v & b.v}; }
+inline Int operator|(Int a, Int b) { return {a.v | b.v}; }
+inline Int operator^(Int a, Int b) { return {a.v ^ b.v}; }
+inline Int operator<<(Int a, int n) { return {(int32_t)((uint32_t)a.v << n)}; }
+inline Int shiftRight(Int a, int n) { return {(int32_t)((uint32_t)a.v >> n)}; }
+inline Int operator==(Int a, Int b) { return {a.v == b.v ? -1 : 0}; }
+
+inline Int roundToInt(Float a) { return {(int32_t)std::nearbyint(a.v)}; }
+inline Float toFloat(Int a) { return {(float)a.v}; }
+
+#endif
+
+} // namespace Simd
+
+#endif // SIMD_H
@@ -0,0 +1,52 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+// Begin/end event tracing, dumped as Chrome trace JSON (chrome://tracing, ui.perfetto.dev).
+//
+// Every thread records into its own fixed size ring buffer, so recording is three relaxed
+// atomic stores and one release store, no locks. When the ring is full the oldest events are
+// overwritten. A buffer outlives its thread (sampling workers are short lived) and is
+// handed to the next new thread, so memory stays bounded by the peak thread count.
+//
+// Names must be string literals (only the pointer is stored).
+// Everything compiles to nothing unless HYDROGEN_TRACING is defined.
+
+#ifdef HYDROGEN_TRACING
+
+#include <string>
+
+namespace Trace {
+
+void begin(const char* name);
+void end();
+void setThreadName(const char* name);
+
+// Writes every buffered event, returns false if the file cannot be opened
+bool dump(const std::string& path);
+// Timestamped file under captures/, returns the path or an empty string on failure
+std::string dump();
+
+struct Scope {
+    explicit Scope(const char* name) { begin(name); }
+    ~Scope() { end(); }
+};
+
+} // namespace Trace
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_SCOPE(name) Trace::Scope TRACE_CONCAT(traceScope, __LINE__)(name)
+#define TRACE_BEGIN(name) Trace::begin(name)
+#define TRACE_END() Trace::end()
+#define TRACE_THREAD_NAME(name) Trace::setThreadName(name)
+
+#else
+
+#define TRACE_SCOPE(name) ((void)0)
+#define TRACE_BEGIN(name) ((void)0)
+#define TRACE_END() ((void)0)
+#define TRACE_THREAD_NAME(name) ((void)0)
+
+#endif // HYDROGEN_TRACING
+
+#endif // TRACE_H
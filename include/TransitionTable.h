@@ -0,0 +1,42 @@
+#ifndef TRANSITION_TABLE_H
+#define TRANSITION_TABLE_H
+
+#include <vector>
+
+// One emission line n_upper -> n_lower, summed over l and m (spin cancels out of every ratio).
+// Atomic units unless the name says otherwise, Z = 1 and a fixed nucleus like the samplers.
+struct SpectralLine {
+    int nUpper;
+    int nLower;
+    double wavelengthNm; // vacuum
+    double lineStrength; // sum over l, l', m, m' of |<n'l'm'|r|nlm>|^2 = sum max(l, l') R^2
+    double oscillatorStrength; // absorption, averaged over the n_lower^2 lower states
+    double einsteinA; // emission rate in 1/s, averaged over the n_upper^2 upper states
+};
+
+// Radial dipole integrals <n'l'|r|nl> of every pair of states up to nMax, in a dense table.
+// Only |l - l'| = 1 is allowed, the other entries stay 0. Both radial functions are a
+// polynomial times e^(-r/n), so one Gauss-Laguerre rule of nMax + 2 nodes, scaled by
+// 1/n + 1/n', integrates a whole (n, n') block exactly. Blocks are independent and run on up
+// to maxThreads cores (0 = all); n = 20 takes milliseconds.
+class TransitionTable {
+public:
+    void build(int nMax, int maxThreads = 0); // no-op if already built for nMax
+    int getMaxN() const { return nMax_; }
+    float getBuildMs() const { return buildMs_; }
+
+    static int stateIndex(int n, int l) { return n * (n - 1) / 2 + l; }
+    double radial(int n1, int l1, int n2, int l2) const { return radial_[stateIndex(n1, l1) * states_ + stateIndex(n2, l2)]; }
+
+    const std::vector<SpectralLine>& getLines() const { return lines_; } // by n_lower, then n_upper
+    static const char* seriesName(int nLower); // Lyman, Balmer, ...
+
+private:
+    int nMax_ = 0;
+    int states_ = 0;
+    std::vector<double> radial_;
+    std::vector<SpectralLine> lines_;
+    float buildMs_ = 0.0f;
+};
+
+#endif // TRANSITION_TABLE_H
@@ -2,11 +2,41 @@
 #define UI_MANAGER_H
 
 #include "imgui.h"
+#include "Nucleus.h"
 #include "QuantumNumbers.h"
+#include "AtomCloud.h"
+#include "FrameCapture.h"
+#include "OrbitalGenerator.h"
+#include "Profiler.h"
+#include "RenderSettings.h"
+#include "TransitionTable.h"
 
 class UIManager {
 public:
-    void drawUI(QuantumNumbers& qn, bool& orbitalNeedsUpdate);
+    void drawUI(QuantumNumbers& qn, Nucleus& nucleus, bool& orbitalNeedsUpdate);
+    void drawCaptureUI(FrameCapture& capture);
+    void drawRenderUI(RenderSettings& settings, const RenderStats& stats, const QuantumNumbers& qn, bool& orbitalNeedsUpdate);
+    void drawAtomUI(AtomSettings& settings, const AtomCloud& atom, bool& atomNeedsUpdate);
+    void drawExpectationUI(const QuantumNumbers& qn);
+    void drawTransitionUI();
+    void drawProfilerUI(Profiler& profiler);
+    void drawDebugUI();
+
+private:
+    bool profilerShowGpu_ = true;
+    std::string profilerExportPath_;
+    std::string traceDumpPath_;
+    OrbitalGenerator::EvaluatorBenchmark evaluatorBenchmark_;
+    bool evaluatorBenchmarked_ = false;
+    char atomText_[128] = "";
+    std::string atomError_;
+    int expectationFunction_ = 0;
+    int expectationKey_ = -1; // function and state of expectationValue_
+    double expectationValue_ = 0.0;
+    TransitionTable transitions_;
+    int transitionMaxN_ = 20;
+    int transitionSeries_ = 0; // n_lower of the shown series, 0 = all
+    bool transitionRates_ = true; // Einstein A, otherwise oscillator strengths
 };
 
 #endif // UI_MANAGER_H
@@ -0,0 +1,31 @@
+#ifndef VECTOR_MATH_H
+#define VECTOR_MATH_H
+
+#include <cstddef>
+
+enum class MathAccuracy {
+    Precise, // within 2 ulp of float (exp, sin, cos) or 2e-7 (log)
+    Fast,    // within 1e-4, relative for exp, absolute for sin and cos; log is absolute
+             // below |log x| = 1 and relative above, like all tiers
+    Visual   // within 1e-2, good enough for where a point lands on screen
+};
+
+// Polynomial exp, log, sin, cos and sincos over float arrays, vectorized with Simd.h.
+// Bounds hold for the ranges the samplers feed in: exp for x in [-87, 88] (the sampler
+// only ever asks for exp(-r / n)), log for normal positive x, sin and cos for |x| <= 1e4
+// (angles are within [0, 2 pi]). Outputs may alias inputs.
+namespace VectorMath {
+
+const char* name(MathAccuracy accuracy);
+double errorBound(MathAccuracy accuracy);
+int getWidth(); // lanes per instruction of this build
+
+void exp(const float* x, float* y, size_t count, MathAccuracy accuracy = MathAccuracy::Precise);
+void log(const float* x, float* y, size_t count, MathAccuracy accuracy = MathAccuracy::Precise);
+void sin(const float* x, float* y, size_t count, MathAccuracy accuracy = MathAccuracy::Precise);
+void cos(const float* x, float* y, size_t count, MathAccuracy accuracy = MathAccuracy::Precise);
+void sincos(const float* x, float* s, float* c, size_t count, MathAccuracy accuracy = MathAccuracy::Precise);
+
+} // namespace VectorMath
+
+#endif // VECTOR_MATH_H
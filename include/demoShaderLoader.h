@@ -1,10 +1,18 @@
 #pragma once
 #include <glad/glad.h>
+#include <string>
+#include <unordered_map>
+
+//binding point of the std140 "Camera" block (projection, view) shared by all programs
+const GLuint CAMERA_BLOCK_BINDING = 0;
 
 struct Shader
 {
 	GLuint id = 0;
 
+	//filled at link time, getUniform does not go to the driver
+	std::unordered_map<std::string, GLint> uniforms;
+
 	bool loadShaderProgramFromData(const char *vertexShaderData, const char *fragmentShaderData);
 	bool loadShaderProgramFromData(const char *vertexShaderData,
 		const char *geometryShaderData, const char *fragmentShaderData);
@@ -18,6 +26,35 @@ struct Shader
 	void clear();
 
 	GLint getUniform(const char *name);
+
+	void reflect();
+};
+
+//uniform block storage, bound once to a binding point and updated once per frame
+struct UniformBuffer
+{
+	GLuint id = 0;
+	GLsizeiptr size = 0;
+
+	void create(GLsizeiptr size, GLuint binding);
+
+	void update(const void *data);
+
+	void clear();
 };
 
 GLint getUniform(GLuint shaderId, const char *name);
+
+struct ShaderProgramSource
+{
+	Shader *shader;
+	const char *vertexShader;
+	const char *fragmentShader;
+};
+
+//loads several programs at once: linked binaries come from the program binary cache, the rest
+//is compiled and linked back to back (in parallel with KHR_parallel_shader_compile) and then cached
+bool loadShaderProgramsFromFiles(ShaderProgramSource *programs, int count);
+
+//where program binaries are kept, an empty path disables the cache
+void setShaderCacheDirectory(const char *path);
@@ -2,21 +2,38 @@
 #define HYDROGEN_H
 
 #include <complex>
+#include <vector>
+#include "Nucleus.h"
+#include "VectorMath.h"
 
 class Hydrogen {
 public:
-    Hydrogen(int n, int m, int l, int s);
+    Hydrogen(int n, int m, int l, int s, const Nucleus& nucleus = Nucleus());
     std::complex<double> getP(double phi);
     double getTheta(double theta);
-    double getR(double r);
+    double getR(double r); // r in Bohr radii
+    double getUnitR(double r); // Z = 1, infinite nuclear mass
+    double getLengthScale() const { return a; }
+
+    // Batched float versions for the samplers, exp and sincos from VectorMath. Any n and l,
+    // from the Laguerre and Legendre polynomials rather than the tabulated cases above.
+    void getR(const float* r, float* out, size_t count, MathAccuracy accuracy = MathAccuracy::Precise) const;
+    void getTheta(const float* theta, float* out, size_t count, MathAccuracy accuracy = MathAccuracy::Precise) const;
+
+    // R_nl(r) e^(r/n) for Z = 1 in double precision, any n. The Laguerre recurrence stays
+    // accurate at large n where the expanded polynomial loses digits to cancellation.
+    static void radialPolynomial(int n, int l, const double* r, double* out, size_t count);
 
 private:
     int n;
     int m;
     int l;
     int s;
-    double a;
-    double a0;
+    double a;     // length scale of the system in Bohr radii
+    double a0;    // Bohr radius in Angstrom
+    double norm;  // a^(-3/2), keeps R normalized when it is stretched by a
+    std::vector<float> radialPoly; // R = radialPoly(r / a) exp(-r / (n a)), norm included
+    std::vector<float> polarPoly;  // Theta = polarPoly(cos theta) sin^|m| theta
 };
 
 #endif // HYDROGEN_H
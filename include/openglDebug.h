@@ -7,4 +7,41 @@ void GLAPIENTRY glDebugOutput(GLenum source,
 	GLenum severity,
 	GLsizei length,
 	const char *message,
-	const void *userParam);
\ No newline at end of file
+	const void *userParam);
+
+//Off: no validation cost at all
+//Aggregated: asynchronous output, messages are only counted per id and printed by flushGLDebugMessages
+//Synchronous: every message is printed from inside the offending call (serializes the driver)
+enum class GLDebugMode
+{
+	Off,
+	Aggregated,
+	Synchronous
+};
+
+//HYDROGEN_GL_DEBUG=off|aggregated|sync, otherwise aggregated in debug builds and off in release
+GLDebugMode getDefaultGLDebugMode();
+
+//needs a current context, falls back to Off without KHR_debug / GL 4.3
+void setGLDebugMode(GLDebugMode mode);
+GLDebugMode getGLDebugMode();
+const char *getGLDebugModeName(GLDebugMode mode);
+
+struct GLDebugCounter
+{
+	unsigned int id;
+	GLenum source;
+	GLenum type;
+	GLenum severity;
+	unsigned int count;
+	const char *message; //first message seen for this id
+};
+
+//snapshot of the table, returns how many entries were written
+int getGLDebugCounters(GLDebugCounter *counters, int maxCounters);
+//messages with ids that did not fit in the table
+unsigned int getGLDebugDroppedMessages();
+void resetGLDebugCounters();
+
+//prints the ids that got new messages since the last flush, one line each
+void flushGLDebugMessages();
@@ -0,0 +1,27 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aColor;
+layout (location = 2) in uint aOrbital;
+
+out vec3 ourColor;
+
+layout (std140) uniform Camera
+{
+    mat4 projection;
+    mat4 view;
+};
+
+const int MAX_ORBITALS = 64;
+
+// per orbital: xyz offset, w uniform scale
+uniform vec4 placements[MAX_ORBITALS];
+uniform mat4 model;
+uniform float pointSize = 2.0;
+
+void main()
+{
+    vec4 placement = placements[aOrbital];
+    gl_Position = projection * view * model * vec4(aPos * placement.w + placement.xyz, 1.0);
+    gl_PointSize = pointSize;
+    ourColor = aColor;
+}
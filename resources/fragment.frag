@@ -4,7 +4,9 @@ out vec4 FragColor;
 
 in vec3 ourColor;
 
+uniform float alpha = 1.0;
+
 void main()
 {
-    FragColor = vec4(ourColor, 1.0);
+    FragColor = vec4(ourColor, alpha);
 }
\ No newline at end of file
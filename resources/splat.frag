@@ -0,0 +1,12 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec3 ourColor;
+
+// every point carries the same share of the total probability
+uniform float pointWeight;
+
+void main()
+{
+    FragColor = vec4(ourColor * pointWeight, pointWeight);
+}
@@ -0,0 +1,21 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aColor;
+
+out vec3 ourColor;
+
+layout (std140) uniform Camera
+{
+    mat4 projection;
+    mat4 view;
+};
+
+uniform mat4 model;
+uniform float pointSize;
+
+void main()
+{
+    gl_Position = projection * view * model * vec4(aPos, 1.0);
+    gl_PointSize = pointSize;
+    ourColor = aColor;
+}
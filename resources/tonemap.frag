@@ -0,0 +1,16 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 uv;
+
+uniform sampler2D accumulation;
+uniform float exposure;
+
+void main()
+{
+    // rgb: color weighted density, a: projected density (1.0 = cloud spread evenly over the screen)
+    vec4 accum = texture(accumulation, uv);
+    vec3 color = accum.rgb / max(accum.a, 1e-8);
+    float intensity = 1.0 - exp(-accum.a * exposure);
+    FragColor = vec4(pow(color * intensity, vec3(1.0 / 2.2)), 1.0);
+}
@@ -4,12 +4,18 @@ layout (location = 1) in vec3 aColor;
 
 out vec3 ourColor;
 
+layout (std140) uniform Camera
+{
+    mat4 projection;
+    mat4 view;
+};
+
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+uniform float pointSize = 2.0;
 
 void main()
 {
     gl_Position = projection * view * model * vec4(aPos, 1.0);
+    gl_PointSize = pointSize;
     ourColor = aColor;
 }
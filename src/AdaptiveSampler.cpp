@@ -0,0 +1,142 @@
+#include "AdaptiveSampler.h"
+#include "HybridOrbital.h"
+#include "OrbitalGenerator.h"
+#include "Trace.h"
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cmath>
+
+static const double Z95 = 1.959964;
+
+RadialStatistics::RadialStatistics(double maxR, int bins) : maxR_(maxR), bins_(std::max(bins, 1), 0) {}
+
+void RadialStatistics::add(const glm::vec3* points, size_t count) {
+    const double binScale = bins_.size() / maxR_;
+    for (size_t i = 0; i < count; ++i) {
+        double r2 = glm::dot(points[i], points[i]);
+        double r = std::sqrt(r2);
+        sumR_ += r;
+        sumR2_ += r2;
+        sumR4_ += r2 * r2;
+        size_t bin = std::min((size_t)(r * binScale), bins_.size() - 1);
+        bins_[bin]++;
+    }
+    count_ += count;
+}
+
+double RadialStatistics::getMeanR() const {
+    return count_ > 0 ? sumR_ / count_ : 0.0;
+}
+
+double RadialStatistics::getMeanRError() const {
+    if (count_ < 2) return INFINITY;
+    double mean = sumR_ / count_;
+    double variance = std::max(sumR2_ / count_ - mean * mean, 0.0);
+    return Z95 * std::sqrt(variance / count_);
+}
+
+double RadialStatistics::getMeanR2() const {
+    return count_ > 0 ? sumR2_ / count_ : 0.0;
+}
+
+double RadialStatistics::getMeanR2Error() const {
+    if (count_ < 2) return INFINITY;
+    double mean = sumR2_ / count_;
+    double variance = std::max(sumR4_ / count_ - mean * mean, 0.0);
+    return Z95 * std::sqrt(variance / count_);
+}
+
+double RadialStatistics::getHistogramError() const {
+    size_t fullest = *std::max_element(bins_.begin(), bins_.end());
+    if (fullest == 0) return INFINITY;
+    double worst = 0.0;
+    for (size_t b : bins_) {
+        double p = (double)b / count_;
+        worst = std::max(worst, p * (1.0 - p));
+    }
+    return Z95 * std::sqrt(worst / count_) / ((double)fullest / count_);
+}
+
+bool RadialStatistics::meets(const AdaptiveTarget& target) const {
+    return getHistogramError() <= target.histogramError && getMeanRError() <= target.momentError * getMeanR() &&
+           getMeanR2Error() <= target.momentError * getMeanR2();
+}
+
+size_t RadialStatistics::pointsFor(const AdaptiveTarget& target) const {
+    if (count_ < 2) return target.minPoints;
+    double ratio = std::max({getHistogramError() / target.histogramError, getMeanRError() / (target.momentError * getMeanR()),
+                             getMeanR2Error() / (target.momentError * getMeanR2())});
+    double needed = count_ * ratio * ratio;
+    return needed < (double)target.maxPoints ? (size_t)std::ceil(needed) : target.maxPoints;
+}
+
+// round(trials, seed, points, colors) is one run of a sampler
+template <typename Round>
+static AdaptiveResult grow(const Round& round, double maxR, uint64_t seed, const AdaptiveTarget& target, std::vector<glm::vec3>& points,
+                           std::vector<glm::vec3>& colors) {
+    TRACE_SCOPE("adaptiveSample");
+    auto start = std::chrono::steady_clock::now();
+    points.clear();
+    colors.clear();
+
+    RadialStatistics stats(maxR, target.bins);
+    AdaptiveResult result;
+    std::vector<glm::vec3> batch, batchColors;
+    const size_t maxPoints = std::max(target.maxPoints, (size_t)1);
+    size_t goal = std::min(std::max(target.minPoints, (size_t)1), maxPoints);
+    size_t accepted = 0;
+    while (true) {
+        // no acceptance rate before the first round, guess low so it rarely falls short
+        double acceptance = result.trials > 0 ? std::max((double)accepted / result.trials, 1e-4) : 0.05;
+        double trials = (goal - points.size()) / acceptance * 1.05 + 1024;
+        int roundTrials = (int)std::min(trials, (double)(INT_MAX / 2));
+
+        round(roundTrials, Random::derive(seed, (uint64_t)result.rounds), batch, batchColors);
+        result.rounds++;
+        result.trials += roundTrials;
+        accepted += batch.size();
+
+        size_t taken = std::min(batch.size(), maxPoints - points.size());
+        points.insert(points.end(), batch.begin(), batch.begin() + taken);
+        colors.insert(colors.end(), batchColors.begin(), batchColors.begin() + taken);
+        stats.add(batch.data(), taken);
+
+        if (points.size() >= target.minPoints && stats.meets(target)) {
+            result.converged = true;
+            break;
+        }
+        if (points.size() >= maxPoints) break;
+        // early estimates of the spread are noisy, so grow at most fourfold per round
+        size_t next = std::max(stats.pointsFor(target), target.minPoints);
+        next = std::min(next, std::max(points.size() * 4, target.minPoints));
+        goal = std::min(std::max(next, points.size() + points.size() / 8 + 1000), maxPoints);
+    }
+
+    result.points = points.size();
+    result.meanR = stats.getMeanR();
+    result.meanRError = stats.getMeanRError();
+    result.meanR2 = stats.getMeanR2();
+    result.meanR2Error = stats.getMeanR2Error();
+    result.histogramError = stats.getHistogramError();
+    result.ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+AdaptiveResult AdaptiveSampler::sample(const QuantumNumbers& qn, std::vector<glm::vec3>& points, std::vector<glm::vec3>& colors, const AdaptiveTarget& target,
+                                       int maxThreads, const SamplerOptions& options) {
+    auto round = [&qn, maxThreads, &options](int trials, uint64_t seed, std::vector<glm::vec3>& batch, std::vector<glm::vec3>& batchColors) {
+        SamplerOptions roundOptions = options;
+        roundOptions.seed = seed;
+        OrbitalGenerator::sampleOrbital(qn, batch, batchColors, trials, maxThreads, roundOptions);
+    };
+    return grow(round, OrbitalGenerator::samplingRadius(qn), options.seed, target, points, colors);
+}
+
+AdaptiveResult AdaptiveSampler::sample(const HybridSet& set, std::vector<glm::vec3>& points, std::vector<glm::vec3>& colors, const AdaptiveTarget& target,
+                                       int maxThreads, uint64_t seed) {
+    auto round = [&set, maxThreads](int trials, uint64_t roundSeed, std::vector<glm::vec3>& batch, std::vector<glm::vec3>& batchColors) {
+        HybridOrbital::sample(set, batch, batchColors, trials, maxThreads, roundSeed);
+    };
+    return grow(round, OrbitalGenerator::samplingRadius(QuantumNumbers(set.n, 0, 0)), seed, target, points, colors);
+}
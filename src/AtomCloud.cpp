@@ -0,0 +1,192 @@
+#include "AtomCloud.h"
+#include "OrbitalGenerator.h"
+#include "Trace.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <thread>
+#include <glm/gtc/type_ptr.hpp>
+
+bool AtomCloud::init() {
+    ShaderProgramSource program = {&shader_, RESOURCES_PATH "vertex.vert", RESOURCES_PATH "fragment.frag"};
+    if (!loadShaderProgramsFromFiles(&program, 1)) return false;
+
+    modelLoc_ = shader_.getUniform("model");
+    pointSizeLoc_ = shader_.getUniform("pointSize");
+    alphaLoc_ = shader_.getUniform("alpha");
+
+    glGenVertexArrays(1, &vao_);
+    glGenBuffers(1, &positionVBO_);
+    glGenBuffers(1, &colorVBO_);
+
+    glBindVertexArray(vao_);
+    glBindBuffer(GL_ARRAY_BUFFER, positionVBO_);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+    glBindBuffer(GL_ARRAY_BUFFER, colorVBO_);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+    glBindVertexArray(0);
+    return true;
+}
+
+void AtomCloud::clear() {
+    shader_.clear();
+    glDeleteVertexArrays(1, &vao_);
+    glDeleteBuffers(1, &positionVBO_);
+    glDeleteBuffers(1, &colorVBO_);
+    vao_ = positionVBO_ = colorVBO_ = 0;
+    cache_.clear();
+    configuration_.clear();
+    first_.clear();
+    count_.clear();
+    totalPoints_ = 0;
+}
+
+glm::vec3 AtomCloud::subshellColor(int n, int l) {
+    static const glm::vec3 colors[] = {
+        glm::vec3(0.25f, 0.55f, 1.0f), // s
+        glm::vec3(0.3f, 1.0f, 0.45f),  // p
+        glm::vec3(1.0f, 0.6f, 0.2f),   // d
+        glm::vec3(1.0f, 0.3f, 0.8f)    // f
+    };
+    // inner shells are drawn paler so they stand out inside the outer ones
+    float pale = (ElectronConfiguration::MAX_N - n) * 0.15f;
+    return glm::mix(colors[std::min(std::max(l, 0), 3)], glm::vec3(1.0f), pale);
+}
+
+// Appends independent samples until points holds target of them. The acceptance rate of
+// the rejection sampler depends on the state, each round sizes its trials from the last one.
+static void sampleCount(const QuantumNumbers& qn, size_t target, std::vector<glm::vec3>& points, int maxThreads, uint64_t seed) {
+    std::vector<glm::vec3> batch;
+    std::vector<glm::vec3> colors;
+    SamplerOptions options;
+    const uint64_t stateSeed = Random::derive(seed, (uint64_t)(qn.n * 64 + qn.l * 8 + qn.m + 4));
+    double acceptance = 0.05;
+    while (points.size() < target) {
+        size_t missing = target - points.size();
+        int trials = (int)std::min(1.2 * missing / acceptance + 1000.0, 2.0e9);
+        options.seed = Random::derive(stateSeed, points.size());
+        OrbitalGenerator::sampleOrbital(qn, batch, colors, trials, maxThreads, options);
+        if (!batch.empty()) acceptance = std::max((double)batch.size() / trials, 1e-4);
+        size_t take = std::min(missing, batch.size());
+        points.insert(points.end(), batch.begin(), batch.begin() + take);
+    }
+}
+
+void AtomCloud::update(const std::vector<Subshell>& configuration, int nuclearCharge, int pointBudget, uint64_t seed) {
+    TRACE_SCOPE("atomUpdate");
+    auto start = std::chrono::steady_clock::now();
+    if (seed != seed_) {
+        cache_.clear();
+        seed_ = seed;
+    }
+
+    configuration_ = configuration;
+    ElectronConfiguration::applyScreening(configuration_, nuclearCharge);
+    const int count = (int)configuration_.size();
+    const int electrons = std::max(1, ElectronConfiguration::electronCount(configuration_));
+
+    // points per m state of every subshell, and the (subshell, m) sets that are short of it
+    struct Job {
+        std::vector<glm::vec3>* points;
+        QuantumNumbers qn;
+        size_t target;
+    };
+    std::vector<size_t> perM(count);
+    std::vector<Job> jobs;
+    for (int i = 0; i < count; ++i) {
+        const Subshell& s = configuration_[i];
+        int states = 2 * s.l + 1;
+        perM[i] = std::max<size_t>(1, (size_t)pointBudget * s.electrons / electrons / states);
+
+        SubshellSamples& samples = cache_[std::make_pair(s.n, s.l)];
+        samples.resize(states);
+        for (int m = -s.l; m <= s.l; ++m) {
+            std::vector<glm::vec3>& points = samples[m + s.l];
+            if (points.size() < perM[i]) jobs.push_back({&points, QuantumNumbers(s.n, s.l, m, 1), perM[i]});
+        }
+    }
+
+    // parallel over (subshell, m) sets, each on one thread; a lone set gets every core
+    const int jobCount = (int)jobs.size();
+    std::atomic<int> next(0);
+    auto worker = [&]() {
+        int j;
+        while ((j = next++) < jobCount) {
+            sampleCount(jobs[j].qn, jobs[j].target, *jobs[j].points, jobCount == 1 ? 0 : 1, seed);
+        }
+    };
+    int threadCount = std::min(jobCount, std::max(1, (int)std::thread::hardware_concurrency()));
+    std::vector<std::thread> threads;
+    for (int t = 1; t < threadCount; ++t) {
+        threads.emplace_back([&worker]() {
+            TRACE_THREAD_NAME("atom sampler");
+            worker();
+        });
+    }
+    worker();
+    for (auto& t : threads) {
+        t.join();
+    }
+    lastSampledJobs_ = jobCount;
+
+    // interleave the m sets so any prefix of a subshell covers all of its m evenly,
+    // cached sets may hold more points than this budget uses
+    TRACE_BEGIN("atomPack");
+    first_.resize(count);
+    count_.resize(count);
+    totalPoints_ = 0;
+    for (int i = 0; i < count; ++i) {
+        first_[i] = totalPoints_;
+        count_[i] = (GLsizei)(perM[i] * (2 * configuration_[i].l + 1));
+        totalPoints_ += count_[i];
+    }
+
+    std::vector<glm::vec3> positions(totalPoints_);
+    std::vector<glm::vec3> colors(totalPoints_);
+    double sumR2 = 0.0;
+    for (int i = 0; i < count; ++i) {
+        const Subshell& s = configuration_[i];
+        const SubshellSamples& samples = cache_[std::make_pair(s.n, s.l)];
+        const float scale = (float)(1.0 / s.zeff);
+        const int states = 2 * s.l + 1;
+        glm::vec3* out = positions.data() + first_[i];
+        for (size_t k = 0; k < perM[i]; ++k) {
+            for (int m = 0; m < states; ++m) {
+                glm::vec3 p = samples[m][k] * scale;
+                sumR2 += glm::dot(p, p);
+                *out++ = p;
+            }
+        }
+        std::fill(colors.begin() + first_[i], colors.begin() + first_[i] + count_[i], subshellColor(s.n, s.l));
+    }
+    cloudRadius_ = totalPoints_ > 0 ? (float)std::sqrt(sumR2 / totalPoints_) : 0.0f;
+
+    glBindBuffer(GL_ARRAY_BUFFER, positionVBO_);
+    glBufferData(GL_ARRAY_BUFFER, positions.size() * sizeof(glm::vec3), positions.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, colorVBO_);
+    glBufferData(GL_ARRAY_BUFFER, colors.size() * sizeof(glm::vec3), colors.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    TRACE_END();
+
+    lastUpdateMs_ = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void AtomCloud::draw(const glm::mat4& model, float fraction, float pointSize, float alpha) {
+    const int count = (int)first_.size();
+    if (count == 0) return;
+
+    drawCount_.resize(count);
+    for (int i = 0; i < count; ++i) {
+        drawCount_[i] = std::min(count_[i], std::max((GLsizei)1, (GLsizei)(count_[i] * fraction)));
+    }
+
+    shader_.bind();
+    glUniformMatrix4fv(modelLoc_, 1, GL_FALSE, glm::value_ptr(model));
+    glUniform1f(pointSizeLoc_, pointSize);
+    glUniform1f(alphaLoc_, alpha);
+    glBindVertexArray(vao_);
+    glMultiDrawArrays(GL_POINTS, first_.data(), drawCount_.data(), count);
+}
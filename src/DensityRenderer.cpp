@@ -0,0 +1,112 @@
+#include "DensityRenderer.h"
+#include <glm/gtc/type_ptr.hpp>
+
+bool DensityRenderer::init() {
+    ShaderProgramSource programs[] = {
+        {&splatShader_, RESOURCES_PATH "splat.vert", RESOURCES_PATH "splat.frag"},
+        {&tonemapShader_, RESOURCES_PATH "fullscreen.vert", RESOURCES_PATH "tonemap.frag"},
+    };
+    if (!loadShaderProgramsFromFiles(programs, 2)) return false;
+
+    splatModelLoc_ = splatShader_.getUniform("model");
+    pointSizeLoc_ = splatShader_.getUniform("pointSize");
+    pointWeightLoc_ = splatShader_.getUniform("pointWeight");
+    exposureLoc_ = tonemapShader_.getUniform("exposure");
+
+    tonemapShader_.bind();
+    glUniform1i(tonemapShader_.getUniform("accumulation"), 0);
+    glUseProgram(0);
+
+    glGenVertexArrays(1, &emptyVAO_);
+    glGenFramebuffers(1, &fbo_);
+    glGenTextures(1, &accumulationTexture_);
+    return true;
+}
+
+void DensityRenderer::clear() {
+    splatShader_.clear();
+    tonemapShader_.clear();
+    glDeleteVertexArrays(1, &emptyVAO_);
+    glDeleteFramebuffers(1, &fbo_);
+    glDeleteTextures(1, &accumulationTexture_);
+    emptyVAO_ = fbo_ = accumulationTexture_ = 0;
+    width_ = height_ = frames_ = 0;
+}
+
+void DensityRenderer::resize(int width, int height) {
+    if (width == width_ && height == height_) return;
+    width_ = width;
+    height_ = height;
+    frames_ = 0;
+
+    // 32 bit float, half floats lose small contributions once a pixel gets bright
+    glBindTexture(GL_TEXTURE_2D, accumulationTexture_);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, width, height, 0, GL_RGBA, GL_FLOAT, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, accumulationTexture_, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void DensityRenderer::render(GLuint vao, GLsizei count, int width, int height, const glm::mat4& model, float exposure) {
+    resetAccumulation();
+    accumulate(vao, count, width, height, model);
+    resolve(exposure);
+}
+
+void DensityRenderer::accumulate(GLuint vao, GLsizei count, int width, int height, const glm::mat4& model) {
+    if (width <= 0 || height <= 0) return;
+
+    GLint previousFramebuffer = 0;
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previousFramebuffer);
+    resize(width, height);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
+    glViewport(0, 0, width, height);
+    if (frames_ == 0) {
+        glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+    }
+
+    glDisable(GL_DEPTH_TEST);
+    glBlendFunc(GL_ONE, GL_ONE);
+
+    // weight so that a cloud spread evenly over the screen accumulates to 1.0 per pixel,
+    // independent of resolution and point count
+    float pointWeight = count > 0 ? (float)width * (float)height / (float)count : 0.0f;
+
+    splatShader_.bind();
+    glUniformMatrix4fv(splatModelLoc_, 1, GL_FALSE, glm::value_ptr(model));
+    glUniform1f(pointSizeLoc_, 1.0f);
+    glUniform1f(pointWeightLoc_, pointWeight);
+    glBindVertexArray(vao);
+    glDrawArrays(GL_POINTS, 0, count);
+    frames_++;
+
+    glBindFramebuffer(GL_FRAMEBUFFER, previousFramebuffer);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glEnable(GL_DEPTH_TEST);
+}
+
+void DensityRenderer::resolve(float exposure) {
+    if (frames_ == 0) return;
+
+    glDisable(GL_DEPTH_TEST);
+    glBlendFunc(GL_ONE, GL_ONE);
+
+    // every batch is normalized to the same total weight, dividing by the batch count
+    // turns the sum into the running average (the color ratio does not depend on it)
+    tonemapShader_.bind();
+    glUniform1f(exposureLoc_, exposure / (float)frames_);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, accumulationTexture_);
+    glBindVertexArray(emptyVAO_);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glEnable(GL_DEPTH_TEST);
+}
@@ -0,0 +1,230 @@
+#include "DepthSorter.h"
+#include "Trace.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <numeric>
+
+template <typename F>
+static void parallelFor(int threadCount, F f) {
+    std::vector<std::thread> threads;
+    for (int t = 1; t < threadCount; ++t) {
+        threads.emplace_back(f, t);
+    }
+    f(0);
+    for (auto& t : threads) {
+        t.join();
+    }
+}
+
+static void blockRange(size_t n, int threadCount, int t, size_t& begin, size_t& end) {
+    begin = n * t / threadCount;
+    end = n * (t + 1) / threadCount;
+}
+
+DepthSorter::DepthSorter()
+    : lastSortMs_(0.0f), lastSortIncremental_(false) {
+    thread_ = std::thread(&DepthSorter::run, this);
+}
+
+DepthSorter::~DepthSorter() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    wake_.notify_all();
+    thread_.join();
+}
+
+void DepthSorter::setPoints(const std::vector<glm::vec3>& points) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        newPoints_ = points;
+        pointsChanged_ = true;
+        finishedReady_ = false;
+        generation_++;
+    }
+    wake_.notify_all();
+}
+
+void DepthSorter::requestSort(const glm::mat4& modelView, size_t count) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        requestedView_ = modelView;
+        requestedCount_ = count;
+        requested_ = true;
+    }
+    wake_.notify_all();
+}
+
+bool DepthSorter::fetchOrder(std::vector<unsigned int>& indices) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!finishedReady_) return false;
+    indices.swap(finished_);
+    finishedReady_ = false;
+    return true;
+}
+
+void DepthSorter::run() {
+    TRACE_THREAD_NAME("depth sorter");
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        wake_.wait(lock, [this] { return stop_ || requested_ || pointsChanged_; });
+        if (stop_) return;
+
+        if (pointsChanged_) {
+            points_.swap(newPoints_);
+            newPoints_.clear();
+            order_.clear();
+            pointsChanged_ = false;
+
+            radius_ = 0.0f;
+            for (const glm::vec3& p : points_) radius_ = std::max(radius_, glm::dot(p, p));
+            radius_ = std::sqrt(radius_) + 1e-6f;
+        }
+        if (!requested_) continue;
+
+        glm::mat4 view = requestedView_;
+        size_t count = requestedCount_;
+        requested_ = false;
+        unsigned int generation = generation_;
+        lock.unlock();
+
+        auto start = std::chrono::steady_clock::now();
+        sort(view, count);
+        std::vector<unsigned int> result = order_;
+        lastSortMs_ = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        lock.lock();
+        // points may have been replaced while sorting, that order is useless now
+        if (generation == generation_) {
+            finished_.swap(result);
+            finishedReady_ = true;
+        }
+    }
+}
+
+void DepthSorter::sort(const glm::mat4& modelView, size_t count) {
+    TRACE_SCOPE("depthSort");
+    const size_t n = std::min(count, points_.size());
+    if (n == 0) {
+        order_.clear();
+        return;
+    }
+
+    int threadCount = std::max(1, (int)std::thread::hardware_concurrency() - 1);
+    if (n < 65536) threadCount = 1;
+
+    // keys are quantized over the depth range of the cloud's bounding sphere
+    glm::vec4 depthRow(modelView[0][2], modelView[1][2], modelView[2][2], modelView[3][2]);
+    // the model may scale the cloud, the row length is that scale
+    const float radius = radius_ * glm::length(glm::vec3(depthRow));
+    float centerDistance = -depthRow.w;
+    float nearest = centerDistance - radius;
+    float scale = 65535.0f / (2.0f * radius);
+
+    // view space z is negative in front of the camera, farthest points get the smallest key
+    auto keyOf = [&](const glm::vec3& p) -> uint16_t {
+        float distance = -(depthRow.x * p.x + depthRow.y * p.y + depthRow.z * p.z + depthRow.w);
+        float k = (2.0f * radius - (distance - nearest)) * scale;
+        return (uint16_t)std::min(65535.0f, std::max(0.0f, k));
+    };
+
+    bool incremental = order_.size() == n;
+    if (!incremental) {
+        order_.resize(n);
+        std::iota(order_.begin(), order_.end(), 0u);
+    }
+
+    keys_.resize(n);
+    parallelFor(threadCount, [&](int t) {
+        size_t begin, end;
+        blockRange(n, threadCount, t, begin, end);
+        for (size_t i = begin; i < end; ++i) keys_[i] = keyOf(points_[order_[i]]);
+    });
+
+    // the previous order is a good start after a small camera move, give up once
+    // the work gets close to what a full radix sort would cost
+    if (incremental && insertionSort(n * 2)) {
+        lastSortIncremental_ = true;
+        return;
+    }
+
+    lastSortIncremental_ = false;
+    radixSort(threadCount);
+}
+
+bool DepthSorter::insertionSort(size_t maxMoves) {
+    const size_t n = keys_.size();
+    size_t moves = 0;
+    for (size_t i = 1; i < n; ++i) {
+        uint16_t key = keys_[i];
+        if (keys_[i - 1] <= key) continue;
+
+        unsigned int index = order_[i];
+        size_t j = i;
+        while (j > 0 && keys_[j - 1] > key) {
+            keys_[j] = keys_[j - 1];
+            order_[j] = order_[j - 1];
+            --j;
+        }
+        keys_[j] = key;
+        order_[j] = index;
+
+        moves += i - j;
+        if (moves > maxMoves) return false;
+    }
+    return true;
+}
+
+void DepthSorter::radixSort(int threadCount) {
+    const size_t n = keys_.size();
+    tmpKeys_.resize(n);
+    tmpOrder_.resize(n);
+
+    std::vector<std::array<size_t, 256>> histograms(threadCount);
+
+    for (int shift = 0; shift < 16; shift += 8) {
+        parallelFor(threadCount, [&](int t) {
+            std::array<size_t, 256>& histogram = histograms[t];
+            histogram.fill(0);
+            size_t begin, end;
+            blockRange(n, threadCount, t, begin, end);
+            for (size_t i = begin; i < end; ++i) histogram[(keys_[i] >> shift) & 0xFF]++;
+        });
+
+        // a digit shared by every key (common for the high byte of a small cloud) needs no pass
+        bool trivial = false;
+        for (int d = 0; d < 256 && !trivial; ++d) {
+            size_t total = 0;
+            for (int t = 0; t < threadCount; ++t) total += histograms[t][d];
+            trivial = total == n;
+        }
+        if (trivial) continue;
+
+        // stable scatter offsets: by digit, then by thread block
+        size_t offset = 0;
+        for (int d = 0; d < 256; ++d) {
+            for (int t = 0; t < threadCount; ++t) {
+                size_t count = histograms[t][d];
+                histograms[t][d] = offset;
+                offset += count;
+            }
+        }
+
+        parallelFor(threadCount, [&](int t) {
+            std::array<size_t, 256>& offsets = histograms[t];
+            size_t begin, end;
+            blockRange(n, threadCount, t, begin, end);
+            for (size_t i = begin; i < end; ++i) {
+                size_t dst = offsets[(keys_[i] >> shift) & 0xFF]++;
+                tmpKeys_[dst] = keys_[i];
+                tmpOrder_[dst] = order_[i];
+            }
+        });
+
+        keys_.swap(tmpKeys_);
+        order_.swap(tmpOrder_);
+    }
+}
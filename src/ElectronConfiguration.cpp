@@ -0,0 +1,195 @@
+#include "ElectronConfiguration.h"
+#include <algorithm>
+#include <cctype>
+
+static const int MADELUNG_ORDER[][2] = {
+    {1, 0}, {2, 0}, {2, 1}, {3, 0}, {3, 1}, {4, 0}, {3, 2}, {4, 1}
+};
+
+char ElectronConfiguration::letter(int l) {
+    static const char letters[] = "spdf";
+    return l >= 0 && l < 4 ? letters[l] : '?';
+}
+
+std::vector<Subshell> ElectronConfiguration::aufbau(int electrons) {
+    std::vector<Subshell> configuration;
+    electrons = std::min(std::max(electrons, 0), MAX_ELECTRONS);
+    for (const auto& nl : MADELUNG_ORDER) {
+        if (electrons <= 0) break;
+        int count = std::min(electrons, capacity(nl[1]));
+        configuration.push_back(Subshell(nl[0], nl[1], count));
+        electrons -= count;
+    }
+    return configuration;
+}
+
+// Digit at text[i], plain or as a UTF-8 superscript; advances i past it
+static int readDigit(const std::string& text, size_t& i) {
+    unsigned char c = (unsigned char)text[i];
+    if (std::isdigit(c)) {
+        ++i;
+        return c - '0';
+    }
+    if (c == 0xC2 && i + 1 < text.size()) {
+        unsigned char d = (unsigned char)text[i + 1];
+        int digit = d == 0xB9 ? 1 : d == 0xB2 ? 2 : d == 0xB3 ? 3 : -1;
+        if (digit >= 0) i += 2;
+        return digit;
+    }
+    if (c == 0xE2 && i + 2 < text.size() && (unsigned char)text[i + 1] == 0x81) {
+        unsigned char d = (unsigned char)text[i + 2];
+        int digit = d == 0xB0 ? 0 : (d >= 0xB4 && d <= 0xB9) ? d - 0xB4 + 4 : -1;
+        if (digit >= 0) i += 3;
+        return digit;
+    }
+    return -1;
+}
+
+static bool readNumber(const std::string& text, size_t& i, int& value) {
+    int digit;
+    bool any = false;
+    value = 0;
+    while (i < text.size() && (digit = readDigit(text, i)) >= 0) {
+        value = value * 10 + digit;
+        any = true;
+    }
+    return any;
+}
+
+bool ElectronConfiguration::parse(const std::string& text, std::vector<Subshell>& configuration, std::string& error) {
+    std::vector<Subshell> result;
+    auto add = [&](const Subshell& subshell) {
+        for (const Subshell& s : result) {
+            if (s.n == subshell.n && s.l == subshell.l) {
+                error = std::string("subshell ") + std::to_string(s.n) + letter(s.l) + " appears twice";
+                return false;
+            }
+        }
+        result.push_back(subshell);
+        return true;
+    };
+
+    size_t i = 0;
+    while (i < text.size()) {
+        unsigned char c = (unsigned char)text[i];
+        if (std::isspace(c) || c == ',' || c == '.') {
+            ++i;
+            continue;
+        }
+
+        if (c == '[') {
+            size_t close = text.find(']', i);
+            if (close == std::string::npos) {
+                error = "missing ] after noble gas core";
+                return false;
+            }
+            std::string core = text.substr(i + 1, close - i - 1);
+            static const char* gases[] = {"He", "Ne", "Ar", "Kr"};
+            static const int gasElectrons[] = {2, 10, 18, 36};
+            int electrons = -1;
+            for (int g = 0; g < 4; ++g) {
+                if (core == gases[g]) electrons = gasElectrons[g];
+            }
+            if (electrons < 0) {
+                error = "unknown core [" + core + "]";
+                return false;
+            }
+            for (const Subshell& s : aufbau(electrons)) {
+                if (!add(s)) return false;
+            }
+            i = close + 1;
+            continue;
+        }
+
+        int n;
+        size_t start = i;
+        if (!readNumber(text, i, n)) {
+            error = "expected a shell number at '" + text.substr(start, 8) + "'";
+            return false;
+        }
+        if (i >= text.size()) {
+            error = "missing subshell letter after " + std::to_string(n);
+            return false;
+        }
+        int l = 0;
+        while (l < 4 && letter(l) != std::tolower((unsigned char)text[i])) ++l;
+        if (l == 4) {
+            error = std::string("unknown subshell letter '") + text[i] + "'";
+            return false;
+        }
+        ++i;
+        if (i < text.size() && text[i] == '^') ++i;
+        int electrons;
+        if (!readNumber(text, i, electrons)) {
+            error = "missing electron count after " + std::to_string(n) + letter(l);
+            return false;
+        }
+
+        std::string name = std::to_string(n) + letter(l);
+        if (n < 1 || n > MAX_N) {
+            error = name + ": only shells 1 to " + std::to_string(MAX_N) + " are available";
+            return false;
+        }
+        if (l >= n) {
+            error = name + " does not exist";
+            return false;
+        }
+        if (electrons < 1 || electrons > capacity(l)) {
+            error = name + " holds 1 to " + std::to_string(capacity(l)) + " electrons";
+            return false;
+        }
+        if (!add(Subshell(n, l, electrons))) return false;
+    }
+
+    if (result.empty()) {
+        error = "no subshells given";
+        return false;
+    }
+    configuration.swap(result);
+    error.clear();
+    return true;
+}
+
+std::string ElectronConfiguration::format(const std::vector<Subshell>& configuration) {
+    std::string text;
+    for (const Subshell& s : configuration) {
+        if (!text.empty()) text += ' ';
+        text += std::to_string(s.n) + letter(s.l) + std::to_string(s.electrons);
+    }
+    return text;
+}
+
+int ElectronConfiguration::electronCount(const std::vector<Subshell>& configuration) {
+    int count = 0;
+    for (const Subshell& s : configuration) count += s.electrons;
+    return count;
+}
+
+// Slater's grouping (1s)(2s,2p)(3s,3p)(3d)(4s,4p)(4d)(4f), ordered by n then s/p, d, f
+static int slaterGroup(const Subshell& s) {
+    return s.n * 3 + std::max(0, s.l - 1);
+}
+
+void ElectronConfiguration::applyScreening(std::vector<Subshell>& configuration, int Z) {
+    for (Subshell& target : configuration) {
+        int group = slaterGroup(target);
+        double shielding = 0.0;
+        for (const Subshell& other : configuration) {
+            int otherGroup = slaterGroup(other);
+            int electrons = &other == &target ? other.electrons - 1 : other.electrons;
+            if (otherGroup == group) {
+                shielding += electrons * (target.n == 1 ? 0.30 : 0.35);
+            } else if (otherGroup > group) {
+                // groups further out do not screen
+            } else if (target.l >= 2) {
+                shielding += electrons * 1.00;
+            } else if (other.n == target.n - 1) {
+                shielding += electrons * 0.85;
+            } else if (other.n < target.n - 1) {
+                shielding += electrons * 1.00;
+            }
+        }
+        // an ion stripped below its screening still feels some charge
+        target.zeff = std::max(Z - shielding, 0.1);
+    }
+}
@@ -0,0 +1,147 @@
+#include "Expectation.h"
+#include "hydrogen.h"
+#include "Quadrature.h"
+#include "Trace.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <thread>
+#include <vector>
+
+const double Expectation::SAMPLING_TAIL = 1e-4;
+std::mutex Expectation::cacheMutex_;
+std::map<Expectation::Key, std::shared_ptr<const StateExpectation>> Expectation::cache_;
+
+static const double PI = 3.14159265358979323846;
+
+// Radial nodes and the weights of r^2 R^2 dr at them, x = 2r/n on the Laguerre rule. Enough
+// nodes for the moments to be exact with room to spare for other integrands.
+static void radialRule(int n, int l, std::vector<double>& r, std::vector<double>& w) {
+    Quadrature::gaussLaguerre(std::min(2 * n + 32, 100), r, w);
+    for (double& node : r) node *= n / 2.0;
+    std::vector<double> P(r.size());
+    Hydrogen::radialPolynomial(n, l, r.data(), P.data(), r.size());
+    for (size_t i = 0; i < r.size(); ++i) w[i] *= n / 2.0 * P[i] * P[i] * r[i] * r[i];
+}
+
+// cos(theta) nodes and the weights of Theta^2 sin(theta) dtheta, Theta as in Hydrogen::getTheta
+static void polarRule(int l, int m, std::vector<double>& c, std::vector<double>& w) {
+    const int am = std::min(std::abs(m), l);
+    Quadrature::gaussLegendre(l + 24, c, w);
+    const double K2 = (2 * l + 1) / 2.0 * std::exp(std::lgamma(l - am + 1.0) - std::lgamma(l + am + 1.0));
+    for (size_t j = 0; j < c.size(); ++j) {
+        // P_l^|m| by the recurrence in l from P_|m|^|m| = (2|m| - 1)!! sin^|m|
+        double s = std::sqrt(std::max(0.0, 1.0 - c[j] * c[j]));
+        double previous = 0.0, P = 1.0;
+        for (int k = 1; k <= am; ++k) P *= (2 * k - 1) * s;
+        for (int k = am + 1; k <= l; ++k) {
+            double next = ((2 * k - 1) * c[j] * P - (k + am - 1) * previous) / (k - am);
+            previous = P;
+            P = next;
+        }
+        w[j] *= K2 * P * P;
+    }
+}
+
+double Expectation::tail(int n, int l, double radius) {
+    std::vector<double> t, w;
+    Quadrature::gaussLaguerre(n + 2, t, w);
+    std::vector<double> r(t.size()), P(t.size());
+    for (size_t i = 0; i < t.size(); ++i) r[i] = radius + t[i] * n / 2.0;
+    Hydrogen::radialPolynomial(n, l, r.data(), P.data(), r.size());
+    double sum = 0.0;
+    for (size_t i = 0; i < t.size(); ++i) sum += w[i] * P[i] * P[i] * r[i] * r[i];
+    return std::exp(-2.0 * radius / n) * n / 2.0 * sum;
+}
+
+std::shared_ptr<const StateExpectation> Expectation::compute(const QuantumNumbers& qn) {
+    TRACE_SCOPE("expectation");
+    auto start = std::chrono::steady_clock::now();
+    auto values = std::make_shared<StateExpectation>();
+
+    std::vector<double> r, wr, c, wc;
+    radialRule(qn.n, qn.l, r, wr);
+    polarRule(qn.l, qn.m, c, wc);
+    double angular = 0.0;
+    for (double w : wc) angular += w;
+    double radial = 0.0;
+    for (size_t i = 0; i < r.size(); ++i) {
+        radial += wr[i];
+        values->meanR += wr[i] * r[i];
+        values->meanR2 += wr[i] * r[i] * r[i];
+        values->meanInvR += wr[i] / r[i];
+    }
+    values->norm = radial * angular;
+    values->meanR *= angular;
+    values->meanR2 *= angular;
+    values->meanInvR *= angular;
+
+    // the tail falls monotonically, bracket the radius and bisect
+    double lo = 0.0, hi = 2.5 * qn.n * qn.n;
+    while (tail(qn.n, qn.l, hi) > SAMPLING_TAIL) {
+        lo = hi;
+        hi *= 2.0;
+    }
+    while (hi - lo > 1e-6 * hi) {
+        double mid = 0.5 * (lo + hi);
+        if (tail(qn.n, qn.l, mid) > SAMPLING_TAIL) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+    values->samplingRadius = hi;
+    values->ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return values;
+}
+
+std::shared_ptr<const StateExpectation> Expectation::get(const QuantumNumbers& qn) {
+    Key key(qn.n, qn.l, std::abs(qn.m));
+    std::lock_guard<std::mutex> lock(cacheMutex_);
+    auto found = cache_.find(key);
+    if (found != cache_.end()) return found->second;
+
+    auto values = compute(qn);
+    cache_[key] = values;
+    return values;
+}
+
+double Expectation::evaluate(const QuantumNumbers& qn, const std::function<double(double, double, double)>& f, int maxThreads) {
+    TRACE_SCOPE("evaluateExpectation");
+    std::vector<double> r, wr, c, wc;
+    radialRule(qn.n, qn.l, r, wr);
+    polarRule(qn.l, qn.m, c, wc);
+    std::vector<double> theta(c.size());
+    for (size_t j = 0; j < c.size(); ++j) theta[j] = std::acos(c[j]);
+    // |e^(i m phi)|^2 / 2 pi is flat, the trapezoid rule is exact for f's harmonics below phis
+    const int phis = 32;
+
+    // one partial sum per radial node, added up in order so the result does not depend on threads
+    std::vector<double> partial(r.size(), 0.0);
+    std::atomic<int> nextNode(0);
+    auto worker = [&]() {
+        int i;
+        while ((i = nextNode++) < (int)r.size()) {
+            if (wr[i] == 0.0) continue;
+            double sum = 0.0;
+            for (size_t j = 0; j < c.size(); ++j) {
+                double angular = 0.0;
+                for (int k = 0; k < phis; ++k) angular += f(r[i], theta[j], 2.0 * PI * (k + 0.5) / phis);
+                sum += wc[j] * angular / phis;
+            }
+            partial[i] = wr[i] * sum;
+        }
+    };
+
+    int threadCount = std::min((int)r.size(), std::max(1, (int)std::thread::hardware_concurrency()));
+    if (maxThreads > 0) threadCount = std::min(threadCount, maxThreads);
+    std::vector<std::thread> threads;
+    for (int t = 1; t < threadCount; ++t) threads.emplace_back(worker);
+    worker();
+    for (auto& t : threads) t.join();
+
+    double total = 0.0;
+    for (double p : partial) total += p;
+    return total;
+}
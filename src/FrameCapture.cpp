@@ -0,0 +1,128 @@
+#include "FrameCapture.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <thread>
+
+static std::string timestamp() {
+    std::time_t now = std::time(nullptr);
+    char buffer[32];
+    std::strftime(buffer, sizeof(buffer), "%Y%m%d_%H%M%S", std::localtime(&now));
+    return buffer;
+}
+
+FrameCapture::FrameCapture()
+    : writer_(FrameFormat::PNG, 16, std::max(1, std::min(4, (int)std::thread::hardware_concurrency() / 2))) {}
+
+void FrameCapture::requestScreenshot() {
+    screenshotRequested_ = true;
+}
+
+void FrameCapture::startRecording() {
+    if (recording_) return;
+    recordingDir_ = "captures/recording_" + timestamp();
+    std::error_code ec;
+    std::filesystem::create_directories(recordingDir_, ec);
+    recordingFrame_ = 0;
+    recording_ = true;
+}
+
+void FrameCapture::stopRecording() {
+    recording_ = false;
+}
+
+void FrameCapture::capture(int width, int height) {
+    collect();
+
+    if (!screenshotRequested_ && !recording_) return;
+    if (width <= 0 || height <= 0) return;
+
+    if (pending_ == RING_SIZE) {
+        // every PBO is still in flight, waiting here is exactly the stall we avoid
+        ringDrops_++;
+        return;
+    }
+
+    Slot& slot = slots_[head_];
+    if (!slot.pbo) {
+        glGenBuffers(1, &slot.pbo);
+    }
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+    if (slot.width != width || slot.height != height) {
+        glBufferData(GL_PIXEL_PACK_BUFFER, (GLsizeiptr)width * height * 4, nullptr, GL_STREAM_READ);
+        slot.width = width;
+        slot.height = height;
+    }
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    if (screenshotRequested_) {
+        std::error_code ec;
+        std::filesystem::create_directories("captures", ec);
+        slot.path = "captures/screenshot_" + timestamp() + "_" + std::to_string(screenshotCount_++);
+        screenshotRequested_ = false;
+    } else {
+        char name[32];
+        snprintf(name, sizeof(name), "/frame_%05d", recordingFrame_++);
+        slot.path = recordingDir_ + name;
+    }
+
+    head_ = (head_ + 1) % RING_SIZE;
+    pending_++;
+}
+
+void FrameCapture::collect() {
+    while (pending_ > 0) {
+        Slot& slot = slots_[(head_ - pending_ + RING_SIZE) % RING_SIZE];
+
+        GLenum status = glClientWaitSync(slot.fence, 0, 0);
+        if (status == GL_TIMEOUT_EXPIRED) break; // oldest not done, the newer ones are not either
+
+        glDeleteSync(slot.fence);
+        slot.fence = 0;
+        pending_--;
+        if (status == GL_WAIT_FAILED) continue;
+
+        size_t size = (size_t)slot.width * slot.height * 4;
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+        void* data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, GL_MAP_READ_BIT);
+        if (data) {
+            // the copy is a plain memcpy from already resolved memory, encoding happens on the writer threads
+            Frame frame;
+            frame.path = slot.path;
+            frame.width = slot.width;
+            frame.height = slot.height;
+            frame.pixels = writer_.acquireBuffer(size);
+            memcpy(frame.pixels.data(), data, size);
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+
+            lastPath_ = slot.path;
+            if (writer_.tryPush(std::move(frame))) {
+                framesCaptured_++;
+            }
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    }
+}
+
+void FrameCapture::clear() {
+    recording_ = false;
+    screenshotRequested_ = false;
+
+    // let in-flight readbacks land so the last frames of a recording are kept
+    glFinish();
+    collect();
+
+    for (Slot& slot : slots_) {
+        if (slot.fence) glDeleteSync(slot.fence);
+        if (slot.pbo) glDeleteBuffers(1, &slot.pbo);
+        slot = Slot();
+    }
+    head_ = 0;
+    pending_ = 0;
+    writer_.flush();
+}
@@ -0,0 +1,136 @@
+#include "FrameGovernor.h"
+#include <algorithm>
+
+// highest quality first; point count goes first since it is the cheapest to give up,
+// resolution follows once the point count alone stops helping
+static const FrameGovernor::Level LEVELS[] = {
+    {1.00f, 1.50f},
+    {1.00f, 1.25f},
+    {1.00f, 1.00f}, // native
+    {0.70f, 1.00f},
+    {0.50f, 1.00f},
+    {0.50f, 0.85f},
+    {0.35f, 0.85f},
+    {0.35f, 0.70f},
+    {0.25f, 0.70f},
+    {0.25f, 0.50f},
+    {0.15f, 0.50f},
+    {0.10f, 0.50f},
+};
+static const int LEVEL_COUNT = sizeof(LEVELS) / sizeof(LEVELS[0]);
+static const int NATIVE_LEVEL = 2;
+
+static const float OVER_THRESHOLD = 1.10f;
+static const float UNDER_THRESHOLD = 0.75f;
+static const int OVER_FRAMES = 10;
+static const int UNDER_FRAMES = 90;
+static const float SMOOTHING = 0.1f;
+
+bool FrameGovernor::init() {
+    for (Query& query : queries_) {
+        glGenQueries(1, &query.begin);
+        glGenQueries(1, &query.end);
+    }
+    reset();
+    return true;
+}
+
+void FrameGovernor::clear() {
+    for (Query& query : queries_) {
+        glDeleteQueries(1, &query.begin);
+        glDeleteQueries(1, &query.end);
+        query = Query();
+    }
+}
+
+void FrameGovernor::reset() {
+    level_ = NATIVE_LEVEL;
+    smoothedMs_ = 0.0f;
+    overFrames_ = underFrames_ = 0;
+    cooldown_ = QUERY_COUNT;
+}
+
+const FrameGovernor::Level& FrameGovernor::getLevel() const {
+    return LEVELS[level_];
+}
+
+int FrameGovernor::getLevelCount() const {
+    return LEVEL_COUNT;
+}
+
+int FrameGovernor::getNativeLevel() const {
+    return NATIVE_LEVEL;
+}
+
+void FrameGovernor::beginFrame() {
+    cpuStart_ = std::chrono::steady_clock::now();
+
+    collect();
+    Query& query = queries_[head_];
+    // all queries still in flight: skip GPU timing this frame rather than wait on one
+    gpuTiming_ = query.begin != 0 && !query.pending;
+    if (gpuTiming_) glQueryCounter(query.begin, GL_TIMESTAMP);
+}
+
+void FrameGovernor::endFrame() {
+    if (gpuTiming_) {
+        Query& query = queries_[head_];
+        glQueryCounter(query.end, GL_TIMESTAMP);
+        query.pending = true;
+        head_ = (head_ + 1) % QUERY_COUNT;
+    }
+    cpuMs_ = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - cpuStart_).count();
+    adjust();
+}
+
+void FrameGovernor::collect() {
+    // oldest first, stop at the first one the GPU has not reached yet
+    for (int i = 0; i < QUERY_COUNT; ++i) {
+        Query& query = queries_[(head_ + i) % QUERY_COUNT];
+        if (!query.pending) continue;
+
+        GLint available = 0;
+        glGetQueryObjectiv(query.end, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) break;
+
+        GLuint64 begin = 0, end = 0;
+        glGetQueryObjectui64v(query.begin, GL_QUERY_RESULT, &begin);
+        glGetQueryObjectui64v(query.end, GL_QUERY_RESULT, &end);
+        gpuMs_ = (float)((end - begin) / 1.0e6);
+        query.pending = false;
+    }
+}
+
+void FrameGovernor::adjust() {
+    // frames measured before the last change still report the old level
+    if (cooldown_ > 0) {
+        cooldown_--;
+        return;
+    }
+
+    float frameMs = std::max(cpuMs_, gpuMs_);
+    smoothedMs_ = smoothedMs_ == 0.0f ? frameMs : smoothedMs_ + SMOOTHING * (frameMs - smoothedMs_);
+
+    if (smoothedMs_ > targetMs_ * OVER_THRESHOLD) {
+        overFrames_++;
+        underFrames_ = 0;
+    } else if (smoothedMs_ < targetMs_ * UNDER_THRESHOLD) {
+        underFrames_++;
+        overFrames_ = 0;
+    } else {
+        overFrames_ = underFrames_ = 0;
+    }
+
+    int level = level_;
+    if (overFrames_ >= OVER_FRAMES && level_ < LEVEL_COUNT - 1) {
+        level++;
+    } else if (underFrames_ >= UNDER_FRAMES && level_ > 0) {
+        level--;
+    }
+    if (level == level_) return;
+
+    level_ = level;
+    smoothedMs_ = 0.0f;
+    overFrames_ = underFrames_ = 0;
+    cooldown_ = QUERY_COUNT + 2;
+}
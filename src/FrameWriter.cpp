@@ -0,0 +1,143 @@
+#include "FrameWriter.h"
+#include "Trace.h"
+#include <stb_image/stb_image_write.h>
+#include <cstdio>
+#include <iostream>
+
+FrameWriter::FrameWriter(FrameFormat format, size_t maxQueued, int encoderThreads)
+    : format_(format), maxQueued_(maxQueued > 0 ? maxQueued : 1) {
+    for (int i = 0; i < (encoderThreads > 0 ? encoderThreads : 1); ++i) {
+        threads_.emplace_back(&FrameWriter::run, this);
+    }
+}
+
+FrameWriter::~FrameWriter() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    queueChanged_.notify_all();
+    for (auto& thread : threads_) {
+        thread.join();
+    }
+}
+
+void FrameWriter::push(Frame frame) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    queueChanged_.wait(lock, [this] { return queue_.size() < maxQueued_; });
+    queue_.push_back(std::move(frame));
+    lock.unlock();
+    queueChanged_.notify_all();
+}
+
+bool FrameWriter::tryPush(Frame frame) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (queue_.size() >= maxQueued_) {
+        framesDropped_++;
+        if (freeBuffers_.size() < maxQueued_) {
+            freeBuffers_.push_back(std::move(frame.pixels));
+        }
+        return false;
+    }
+    queue_.push_back(std::move(frame));
+    lock.unlock();
+    queueChanged_.notify_all();
+    return true;
+}
+
+void FrameWriter::flush() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    queueChanged_.wait(lock, [this] { return queue_.empty() && busy_ == 0; });
+}
+
+std::vector<unsigned char> FrameWriter::acquireBuffer(size_t size) {
+    std::vector<unsigned char> buffer;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!freeBuffers_.empty()) {
+            buffer = std::move(freeBuffers_.back());
+            freeBuffers_.pop_back();
+        }
+    }
+    buffer.resize(size);
+    return buffer;
+}
+
+void FrameWriter::setFormat(FrameFormat format) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    format_ = format;
+}
+
+FrameFormat FrameWriter::getFormat() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return format_;
+}
+
+size_t FrameWriter::getQueueDepth() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return queue_.size();
+}
+
+size_t FrameWriter::getFramesWritten() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return framesWritten_;
+}
+
+size_t FrameWriter::getFramesDropped() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return framesDropped_;
+}
+
+void FrameWriter::run() {
+    TRACE_THREAD_NAME("frame writer");
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        queueChanged_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+        if (queue_.empty()) {
+            return; // stop_ was requested and everything has been written
+        }
+
+        Frame frame = std::move(queue_.front());
+        queue_.pop_front();
+        FrameFormat format = format_;
+        busy_++;
+        lock.unlock();
+        queueChanged_.notify_all();
+
+        encode(frame, format);
+
+        lock.lock();
+        busy_--;
+        framesWritten_++;
+        if (freeBuffers_.size() < maxQueued_) {
+            freeBuffers_.push_back(std::move(frame.pixels));
+        }
+        queueChanged_.notify_all();
+    }
+}
+
+void FrameWriter::encode(Frame& frame, FrameFormat format) {
+    TRACE_SCOPE("encodeFrame");
+    const int stride = frame.width * 4;
+    const unsigned char* lastRow = frame.pixels.data() + (size_t)(frame.height - 1) * stride;
+
+    if (format == FrameFormat::PNG) {
+        std::string path = frame.path + ".png";
+        // negative stride flips the bottom-up GL image while encoding
+        if (!stbi_write_png(path.c_str(), frame.width, frame.height, 4, lastRow, -stride)) {
+            std::cout << "Error writing frame: " << path << "\n";
+        }
+        return;
+    }
+
+    std::string path = frame.path + ".raw";
+    FILE* f = fopen(path.c_str(), "wb");
+    if (!f) {
+        std::cout << "Error writing frame: " << path << "\n";
+        return;
+    }
+    for (int y = 0; y < frame.height; ++y) {
+        fwrite(lastRow - (size_t)y * stride, 1, stride, f);
+    }
+    fclose(f);
+}
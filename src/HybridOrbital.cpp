@@ -0,0 +1,323 @@
+#include "HybridOrbital.h"
+#include "hydrogen.h"
+#include "OrbitalGenerator.h"
+#include "Random.h"
+#include "Trace.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <thread>
+
+static const double PI = 3.14159265358979323846;
+
+const char* HybridOrbital::name(HybridType type) {
+    switch (type) {
+    case HybridType::SP: return "sp";
+    case HybridType::SP2: return "sp2";
+    case HybridType::SP3: return "sp3";
+    case HybridType::DSP3: return "dsp3";
+    default: return "none";
+    }
+}
+
+bool HybridOrbital::preset(HybridType type, int n, HybridSet& set) {
+    const RealOrbital s = {0, 0}, px = {1, 1}, py = {1, -1}, pz = {1, 0}, dz2 = {2, 0};
+    const double r2 = 1.0 / std::sqrt(2.0);
+    const double r3 = 1.0 / std::sqrt(3.0);
+    const double r6 = 1.0 / std::sqrt(6.0);
+
+    set.n = n;
+    switch (type) {
+    case HybridType::SP:
+        // along +z and -z
+        set.basis = {s, pz};
+        set.coefficients = {{r2, r2}, {r2, -r2}};
+        break;
+    case HybridType::SP2:
+        // 120 degrees apart in the xy plane
+        set.basis = {s, px, py};
+        set.coefficients = {{r3, 2.0 * r6, 0.0}, {r3, -r6, r2}, {r3, -r6, -r2}};
+        break;
+    case HybridType::SP3:
+        // toward alternate corners of a cube
+        set.basis = {s, px, py, pz};
+        set.coefficients = {{0.5, 0.5, 0.5, 0.5}, {0.5, 0.5, -0.5, -0.5}, {0.5, -0.5, 0.5, -0.5}, {0.5, -0.5, -0.5, 0.5}};
+        break;
+    case HybridType::DSP3:
+        // sp2 around the equator, p_z and d_z2 mixed into the two axial lobes
+        set.basis = {s, px, py, pz, dz2};
+        set.coefficients = {{r3, 2.0 * r6, 0.0, 0.0, 0.0}, {r3, -r6, r2, 0.0, 0.0}, {r3, -r6, -r2, 0.0, 0.0},
+                            {0.0, 0.0, 0.0, r2, r2}, {0.0, 0.0, 0.0, -r2, r2}};
+        break;
+    default:
+        return false;
+    }
+
+    for (const RealOrbital& orbital : set.basis) {
+        if (orbital.l >= n) return false;
+    }
+    return true;
+}
+
+// Distinct factors of a set: one radial function per l, one polar function per (l, |m|),
+// and the basis orbitals as products of those
+class HybridBasis {
+public:
+    static const size_t BLOCK = 256;
+
+    explicit HybridBasis(const HybridSet& set) : set_(set) {
+        for (const RealOrbital& orbital : set.basis) {
+            int radial = find(radialL_, orbital.l);
+            if (radial < 0) {
+                radial = (int)radialL_.size();
+                radialL_.push_back(orbital.l);
+                radialFunctions_.push_back(Hydrogen(set.n, 0, orbital.l, 1));
+            }
+            int polarKey = orbital.l * 16 + std::abs(orbital.m);
+            int polar = find(polarKey_, polarKey);
+            if (polar < 0) {
+                polar = (int)polarKey_.size();
+                polarKey_.push_back(polarKey);
+                polarFunctions_.push_back(Hydrogen(set.n, std::abs(orbital.m), orbital.l, 1));
+            }
+            radialIndex_.push_back(radial);
+            polarIndex_.push_back(polar);
+        }
+        radial_.resize(radialL_.size() * BLOCK);
+        polar_.resize(polarKey_.size() * BLOCK);
+        basis_.resize(set.basis.size() * BLOCK);
+    }
+
+    // count <= BLOCK, each factor is evaluated over the whole block before the next one
+    void evaluate(const glm::vec3* points, size_t count, double* psi) {
+        double r[BLOCK], theta[BLOCK], phi[BLOCK];
+        for (size_t i = 0; i < count; ++i) {
+            glm::dvec3 p(points[i]);
+            r[i] = glm::length(p);
+            theta[i] = r[i] > 0.0 ? std::acos(std::max(-1.0, std::min(1.0, p.z / r[i]))) : 0.0;
+            phi[i] = std::atan2(p.y, p.x);
+        }
+        for (size_t k = 0; k < radialL_.size(); ++k) {
+            for (size_t i = 0; i < count; ++i) radial_[k * BLOCK + i] = radialFunctions_[k].getR(r[i]);
+        }
+        for (size_t k = 0; k < polarKey_.size(); ++k) {
+            for (size_t i = 0; i < count; ++i) polar_[k * BLOCK + i] = polarFunctions_[k].getTheta(theta[i]);
+        }
+
+        const size_t basisCount = set_.basis.size();
+        for (size_t j = 0; j < basisCount; ++j) {
+            int m = set_.basis[j].m;
+            double norm = m == 0 ? 1.0 / std::sqrt(2.0 * PI) : 1.0 / std::sqrt(PI);
+            // R_nl has n - l - 1 nodes and starts out positive
+            if ((set_.n - set_.basis[j].l - 1) % 2) norm = -norm;
+            const double* radial = &radial_[radialIndex_[j] * BLOCK];
+            const double* polar = &polar_[polarIndex_[j] * BLOCK];
+            double* out = &basis_[j * BLOCK];
+            for (size_t i = 0; i < count; ++i) {
+                double azimuthal = m > 0 ? std::cos(m * phi[i]) : m < 0 ? std::sin(-m * phi[i]) : 1.0;
+                out[i] = radial[i] * polar[i] * azimuthal * norm;
+            }
+        }
+
+        const size_t hybrids = set_.coefficients.size();
+        for (size_t i = 0; i < count; ++i) {
+            for (size_t h = 0; h < hybrids; ++h) {
+                const std::vector<double>& row = set_.coefficients[h];
+                double value = 0.0;
+                for (size_t j = 0; j < basisCount; ++j) value += row[j] * basis_[j * BLOCK + i];
+                psi[i * hybrids + h] = value;
+            }
+        }
+    }
+
+private:
+    static int find(const std::vector<int>& keys, int key) {
+        for (size_t i = 0; i < keys.size(); ++i) {
+            if (keys[i] == key) return (int)i;
+        }
+        return -1;
+    }
+
+    const HybridSet& set_;
+    std::vector<int> radialL_;
+    std::vector<int> polarKey_;
+    std::vector<Hydrogen> radialFunctions_;
+    std::vector<Hydrogen> polarFunctions_;
+    std::vector<int> radialIndex_;
+    std::vector<int> polarIndex_;
+    std::vector<double> radial_;
+    std::vector<double> polar_;
+    std::vector<double> basis_;
+};
+
+void HybridOrbital::evaluate(const HybridSet& set, const glm::vec3* points, size_t count, double* psi) {
+    HybridBasis basis(set);
+    const size_t hybrids = set.coefficients.size();
+    for (size_t begin = 0; begin < count; begin += HybridBasis::BLOCK) {
+        size_t block = std::min(HybridBasis::BLOCK, count - begin);
+        basis.evaluate(points + begin, block, psi + begin * hybrids);
+    }
+}
+
+glm::vec3 HybridOrbital::hybridColor(int h) {
+    static const glm::vec3 colors[] = {
+        glm::vec3(0.2f, 0.5f, 1.0f),
+        glm::vec3(1.0f, 0.3f, 0.2f),
+        glm::vec3(0.3f, 1.0f, 0.4f),
+        glm::vec3(1.0f, 0.85f, 0.2f),
+        glm::vec3(0.85f, 0.35f, 1.0f),
+        glm::vec3(0.2f, 0.95f, 0.95f),
+        glm::vec3(1.0f, 0.55f, 0.75f),
+        glm::vec3(0.9f, 0.9f, 0.9f)
+    };
+    return colors[h % 8];
+}
+
+// Piecewise constant bound on f(r) = r^2 sum_j R_j(r)^2 over the basis orbitals, the radial
+// density of the whole cloud times the basis size. Candidates pick a step in proportion to its
+// height, r uniformly within it and a uniform direction, so they follow the cloud's radial
+// profile instead of filling the ball.
+struct RadialEnvelope {
+    static const int STEPS = 1024;
+    double step = 0.0;
+    std::vector<double> height;     // >= f over the step
+    std::vector<double> cumulative; // of height * step, normalized to 1 at the end
+
+    RadialEnvelope(const HybridSet& set, double maxR) : step(maxR / STEPS), height(STEPS), cumulative(STEPS) {
+        // f sampled 8 times per step, the margin covers what falls between the samples
+        const int samples = 8;
+        std::vector<double> r(STEPS * samples + 1), P(r.size()), f(r.size(), 0.0);
+        for (size_t i = 0; i < r.size(); ++i) r[i] = step * i / samples;
+        for (const RealOrbital& orbital : set.basis) {
+            Hydrogen::radialPolynomial(set.n, orbital.l, r.data(), P.data(), r.size());
+            for (size_t i = 0; i < r.size(); ++i) f[i] += P[i] * P[i];
+        }
+        double total = 0.0;
+        for (int k = 0; k < STEPS; ++k) {
+            double top = 0.0;
+            for (int i = k * samples; i <= (k + 1) * samples; ++i) top = std::max(top, f[i] * r[i] * r[i] * std::exp(-2.0 * r[i] / set.n));
+            height[k] = top * 1.05;
+            total += height[k];
+            cumulative[k] = total;
+        }
+        for (double& c : cumulative) c /= total;
+    }
+};
+
+// count <= HybridBasis::BLOCK candidates drawn from the envelope, with the envelope's height at each
+static void envelopeCandidates(Random& gen, const RadialEnvelope& envelope, glm::vec3* points, double* r2, double* height, size_t count) {
+    float u[4][HybridBasis::BLOCK];
+    for (auto& draws : u) gen.fill(draws, count);
+    for (size_t i = 0; i < count; ++i) {
+        int k = (int)(std::upper_bound(envelope.cumulative.begin(), envelope.cumulative.end(), (double)u[0][i]) - envelope.cumulative.begin());
+        k = std::min(k, RadialEnvelope::STEPS - 1);
+        double r = envelope.step * (k + u[1][i]);
+        double cosTheta = 2.0 * u[2][i] - 1.0;
+        double sinTheta = std::sqrt(std::max(0.0, 1.0 - cosTheta * cosTheta));
+        double phi = 2.0 * PI * u[3][i];
+        points[i] = glm::vec3((float)(r * sinTheta * std::cos(phi)), (float)(r * sinTheta * std::sin(phi)), (float)(r * cosTheta));
+        r2[i] = r * r;
+        height[i] = envelope.height[k];
+    }
+}
+
+// Candidate density is proportional to height / r^2, so hybrid h is accepted with probability
+// r^2 psi_h^2 / (height bound). By Cauchy-Schwarz psi_h^2 <= sum_j R_j^2 * sum_j c_hj^2 Y_j^2,
+// and a real Y_lm^2 never exceeds (2l + 1) / 4 pi, so with bound the largest
+// sum_j c_hj^2 (2 l_j + 1) / 4 pi of any hybrid the ratio stays below 1.
+static void sampleHybridChunk(const HybridSet& set, const RadialEnvelope& envelope, double bound, const Random& stream, int trials,
+                              std::vector<glm::vec3>& points, std::vector<glm::vec3>& colors) {
+    TRACE_SCOPE("sampleHybridChunk");
+    Random gen = stream;
+    HybridBasis basis(set);
+    const int hybrids = set.getHybridCount();
+
+    glm::vec3 candidates[HybridBasis::BLOCK];
+    double r2[HybridBasis::BLOCK], height[HybridBasis::BLOCK];
+    std::vector<double> psi(HybridBasis::BLOCK * hybrids);
+    std::vector<float> u(HybridBasis::BLOCK * hybrids);
+    for (int begin = 0; begin < trials; begin += (int)HybridBasis::BLOCK) {
+        int block = std::min((int)HybridBasis::BLOCK, trials - begin);
+        envelopeCandidates(gen, envelope, candidates, r2, height, block);
+        basis.evaluate(candidates, block, psi.data());
+        gen.fill(u.data(), (size_t)block * hybrids);
+
+        // every hybrid gets its own test on the shared evaluation
+        for (int i = 0; i < block; ++i) {
+            for (int h = 0; h < hybrids; ++h) {
+                double density = psi[i * hybrids + h] * psi[i * hybrids + h] * r2[i];
+                if (density > u[i * hybrids + h] * bound * height[i]) {
+                    points.push_back(candidates[i]);
+                    colors.push_back(HybridOrbital::hybridColor(h));
+                }
+            }
+        }
+    }
+}
+
+void HybridOrbital::sample(const HybridSet& set, std::vector<glm::vec3>& points, std::vector<glm::vec3>& colors, int trials, int maxThreads,
+                           uint64_t seed) {
+    TRACE_SCOPE("sampleHybrid");
+    points.clear();
+    colors.clear();
+    const int hybrids = set.getHybridCount();
+    if (hybrids == 0) return;
+
+    Random gen(seed);
+
+    // radius of the shell's s orbital, the most diffuse of its basis
+    const double maxR = OrbitalGenerator::samplingRadius(QuantumNumbers(set.n, 0, 0));
+    const RadialEnvelope envelope(set, maxR);
+
+    // Every hybrid shares one bound so they all keep the same acceptance per unit of
+    // probability and end up with equal shares of the cloud
+    double bound = 0.0;
+    for (const std::vector<double>& row : set.coefficients) {
+        double angular = 0.0;
+        for (size_t j = 0; j < set.basis.size(); ++j) angular += row[j] * row[j] * (2 * set.basis[j].l + 1);
+        bound = std::max(bound, angular / (4.0 * PI));
+    }
+
+    const int chunkSize = 1 << 16;
+    int chunks = (std::max(trials, 0) + chunkSize - 1) / chunkSize;
+    std::vector<Random> streams;
+    streams.reserve(chunks);
+    for (int c = 0; c < chunks; ++c) {
+        gen.longJump();
+        streams.push_back(gen);
+    }
+    std::vector<std::vector<glm::vec3>> chunkPoints(chunks);
+    std::vector<std::vector<glm::vec3>> chunkColors(chunks);
+
+    std::atomic<int> nextChunk(0);
+    auto worker = [&]() {
+        int c;
+        while ((c = nextChunk++) < chunks) {
+            int count = std::min(chunkSize, trials - c * chunkSize);
+            sampleHybridChunk(set, envelope, bound, streams[c], count, chunkPoints[c], chunkColors[c]);
+        }
+    };
+
+    int threadCount = std::min(chunks, std::max(1, (int)std::thread::hardware_concurrency()));
+    if (maxThreads > 0) threadCount = std::min(threadCount, maxThreads);
+    std::vector<std::thread> threads;
+    for (int t = 1; t < threadCount; ++t) {
+        threads.emplace_back([&worker]() {
+            TRACE_THREAD_NAME("sampler");
+            worker();
+        });
+    }
+    worker();
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    size_t total = 0;
+    for (const auto& chunk : chunkPoints) total += chunk.size();
+    points.reserve(total);
+    colors.reserve(total);
+    for (int c = 0; c < chunks; ++c) {
+        points.insert(points.end(), chunkPoints[c].begin(), chunkPoints[c].end());
+        colors.insert(colors.end(), chunkColors[c].begin(), chunkColors[c].end());
+    }
+}
@@ -0,0 +1,34 @@
+#include "LevelOfDetail.h"
+#include <algorithm>
+#include <cmath>
+
+LodSelection LevelOfDetail::select(int totalPoints, float cloudRadius, float distance, float fovY, int viewportHeight,
+                                   float pointsPerPixel, float basePointSize, float baseAlpha, float budgetScale) const {
+    LodSelection selection = {totalPoints, basePointSize, baseAlpha};
+    if (totalPoints <= 0 || viewportHeight <= 0) return selection;
+
+    // inside the cloud it covers the whole screen, no reduction from the projected size
+    float projectedCount = (float)totalPoints;
+    if (pointsPerPixel > 0.0f && distance > cloudRadius) {
+        float projectedRadius = cloudRadius / (distance * std::tan(fovY * 0.5f)) * viewportHeight * 0.5f;
+        projectedCount = 3.14159265f * projectedRadius * projectedRadius * pointsPerPixel;
+    }
+
+    float count = std::min(projectedCount, (float)totalPoints * budgetScale);
+    if (count < (float)totalPoints) {
+        // steps of ~9% keep the count (and the depth sort keyed on it) stable between frames
+        count = std::exp2(std::floor(std::log2(std::max(count, 1.0f)) * 8.0f) / 8.0f);
+    }
+    int drawCount = std::max(std::min(totalPoints, 1000), std::min(totalPoints, (int)count));
+    float fraction = (float)drawCount / (float)totalPoints;
+
+    // fewer points cover less of the screen: opaque points grow to keep the covered area,
+    // translucent ones raise alpha so the stacked opacity of the dropped points is kept
+    selection.drawCount = drawCount;
+    if (baseAlpha >= 1.0f) {
+        selection.pointSize = std::min(basePointSize * 4.0f, basePointSize / std::sqrt(fraction));
+    } else {
+        selection.alpha = 1.0f - std::pow(1.0f - baseAlpha, 1.0f / fraction);
+    }
+    return selection;
+}
@@ -0,0 +1,94 @@
+#include "LookupTable.h"
+#include "hydrogen.h"
+#include "Trace.h"
+#include <chrono>
+#include <cmath>
+
+std::mutex OrbitalTables::cacheMutex_;
+std::map<OrbitalTables::Key, std::shared_ptr<const OrbitalTables>> OrbitalTables::cache_;
+
+bool LookupTable::build(const std::function<double(double)>& f, double lo, double hi, double maxError) {
+    double peak = 0.0;
+    for (int i = 0; i <= 4096; ++i) peak = std::max(peak, std::abs(f(lo + (hi - lo) * i / 4096.0)));
+    if (peak == 0.0) peak = 1.0;
+
+    lo_ = lo;
+    for (int segments = 16; segments <= MAX_SEGMENTS; segments *= 2) {
+        invStep_ = segments / (hi - lo);
+        fit(f, segments);
+
+        // a cubic spline's error peaks between the knots
+        double error = 0.0;
+        const double step = (hi - lo) / segments;
+        for (int i = 0; i < segments; ++i) {
+            for (double u : {0.25, 0.5, 0.75}) {
+                double x = lo + (i + u) * step;
+                error = std::max(error, std::abs((*this)(x) - f(x)));
+            }
+        }
+        measuredError_ = error / peak;
+        if (measuredError_ <= maxError) return true;
+    }
+    return false;
+}
+
+void LookupTable::fit(const std::function<double(double)>& f, int segments) {
+    const int n = segments;
+    const double h = 1.0 / invStep_;
+    std::vector<double> y(n + 1);
+    for (int i = 0; i <= n; ++i) y[i] = f(lo_ + i * h);
+
+    // end slopes from the function itself, second order one sided differences
+    const double e = h * 1e-3;
+    const double hi = lo_ + n * h;
+    double slopeLo = (-3.0 * f(lo_) + 4.0 * f(lo_ + e) - f(lo_ + 2.0 * e)) / (2.0 * e);
+    double slopeHi = (3.0 * f(hi) - 4.0 * f(hi - e) + f(hi - 2.0 * e)) / (2.0 * e);
+
+    // clamped spline: tridiagonal system for the second derivatives M, Thomas algorithm
+    std::vector<double> diag(n + 1, 4.0), rhs(n + 1), M(n + 1);
+    diag[0] = diag[n] = 2.0;
+    rhs[0] = 6.0 / h * ((y[1] - y[0]) / h - slopeLo);
+    rhs[n] = 6.0 / h * (slopeHi - (y[n] - y[n - 1]) / h);
+    for (int i = 1; i < n; ++i) rhs[i] = 6.0 / (h * h) * (y[i + 1] - 2.0 * y[i] + y[i - 1]);
+    for (int i = 1; i <= n; ++i) {
+        double w = 1.0 / diag[i - 1];
+        diag[i] -= w;
+        rhs[i] -= w * rhs[i - 1];
+    }
+    M[n] = rhs[n] / diag[n];
+    for (int i = n - 1; i >= 0; --i) M[i] = (rhs[i] - M[i + 1]) / diag[i];
+
+    segments_.resize(n);
+    last_ = n - 1;
+    for (int i = 0; i < n; ++i) {
+        Segment& s = segments_[i];
+        s.a = (float)y[i];
+        s.b = (float)(y[i + 1] - y[i] - h * h * (2.0 * M[i] + M[i + 1]) / 6.0);
+        s.c = (float)(h * h * M[i] / 2.0);
+        s.d = (float)(h * h * (M[i + 1] - M[i]) / 6.0);
+    }
+}
+
+std::shared_ptr<const OrbitalTables> OrbitalTables::build(const QuantumNumbers& qn, double maxR, double maxError) {
+    TRACE_SCOPE("buildOrbitalTables");
+    auto start = std::chrono::steady_clock::now();
+    auto tables = std::make_shared<OrbitalTables>();
+    Hydrogen h(qn.n, qn.m, qn.l, qn.s);
+    tables->radial.build([&h](double r) { return h.getR(r); }, 0.0, maxR, maxError);
+    tables->polar.build([&h](double theta) { return h.getTheta(theta); }, 0.0, 3.14159265358979323846, maxError);
+    tables->buildMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return tables;
+}
+
+std::shared_ptr<const OrbitalTables> OrbitalTables::get(const QuantumNumbers& qn, double maxR, double maxError) {
+    Key key(qn.n, qn.l, std::abs(qn.m), maxR, maxError);
+    std::lock_guard<std::mutex> lock(cacheMutex_);
+    auto found = cache_.find(key);
+    if (found != cache_.end()) return found->second;
+
+    // a few dozen states at a handful of error bounds, start over rather than track use
+    if (cache_.size() >= 128) cache_.clear();
+    auto tables = build(qn, maxR, maxError);
+    cache_[key] = tables;
+    return tables;
+}
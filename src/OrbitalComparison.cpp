@@ -0,0 +1,167 @@
+#include "OrbitalComparison.h"
+#include "OrbitalGenerator.h"
+#include "Trace.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <thread>
+#include <glm/gtc/type_ptr.hpp>
+
+bool OrbitalComparison::init() {
+    ShaderProgramSource program = {&shader_, RESOURCES_PATH "comparison.vert", RESOURCES_PATH "fragment.frag"};
+    if (!loadShaderProgramsFromFiles(&program, 1)) return false;
+
+    modelLoc_ = shader_.getUniform("model");
+    placementsLoc_ = shader_.getUniform("placements");
+    pointSizeLoc_ = shader_.getUniform("pointSize");
+    alphaLoc_ = shader_.getUniform("alpha");
+
+    glGenVertexArrays(1, &vao_);
+    glGenBuffers(1, &positionVBO_);
+    glGenBuffers(1, &colorVBO_);
+    glGenBuffers(1, &orbitalVBO_);
+
+    glBindVertexArray(vao_);
+    glBindBuffer(GL_ARRAY_BUFFER, positionVBO_);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+    glBindBuffer(GL_ARRAY_BUFFER, colorVBO_);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+    glBindBuffer(GL_ARRAY_BUFFER, orbitalVBO_);
+    glEnableVertexAttribArray(2);
+    glVertexAttribIPointer(2, 1, GL_UNSIGNED_INT, sizeof(GLuint), (void*)0);
+    glBindVertexArray(0);
+    return true;
+}
+
+void OrbitalComparison::clear() {
+    shader_.clear();
+    glDeleteVertexArrays(1, &vao_);
+    glDeleteBuffers(1, &positionVBO_);
+    glDeleteBuffers(1, &colorVBO_);
+    glDeleteBuffers(1, &orbitalVBO_);
+    vao_ = positionVBO_ = colorVBO_ = orbitalVBO_ = 0;
+    first_.clear();
+    count_.clear();
+    totalPoints_ = 0;
+}
+
+std::vector<QuantumNumbers> OrbitalComparison::statesFor(ComparisonMode mode, const QuantumNumbers& qn) {
+    std::vector<QuantumNumbers> states;
+    int lBegin = mode == ComparisonMode::Shell ? 0 : qn.l;
+    int lEnd = mode == ComparisonMode::Shell ? qn.n - 1 : qn.l;
+    for (int l = lBegin; l <= lEnd; ++l) {
+        for (int m = -l; m <= l; ++m) {
+            states.push_back(QuantumNumbers(qn.n, l, m, qn.s));
+        }
+    }
+    return states;
+}
+
+void OrbitalComparison::generate(const std::vector<QuantumNumbers>& states, int trials, const SamplerOptions& options) {
+    TRACE_SCOPE("comparisonGenerate");
+    const int count = std::min((int)states.size(), MAX_ORBITALS);
+    std::vector<std::vector<glm::vec3>> points(count);
+    std::vector<std::vector<glm::vec3>> colors(count);
+
+    // parallel over orbitals, each one sampled on a single thread so the cores are not
+    // oversubscribed by the chunked sampler
+    std::atomic<int> next(0);
+    auto worker = [&]() {
+        int i;
+        while ((i = next++) < count) {
+            SamplerOptions stateOptions = options;
+            stateOptions.seed = Random::derive(options.seed, i);
+            OrbitalGenerator::sampleOrbital(states[i], points[i], colors[i], trials, 1, stateOptions);
+        }
+    };
+    int threadCount = std::min(count, std::max(1, (int)std::thread::hardware_concurrency()));
+    std::vector<std::thread> threads;
+    for (int t = 1; t < threadCount; ++t) {
+        threads.emplace_back([&worker]() {
+            TRACE_THREAD_NAME("comparison sampler");
+            worker();
+        });
+    }
+    worker();
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    first_.resize(count);
+    count_.resize(count);
+    radius_.resize(count);
+    totalPoints_ = 0;
+    for (int i = 0; i < count; ++i) {
+        first_[i] = totalPoints_;
+        count_[i] = (GLsizei)points[i].size();
+        totalPoints_ += count_[i];
+
+        double sumR2 = 0.0;
+        for (const glm::vec3& p : points[i]) sumR2 += glm::dot(p, p);
+        radius_[i] = count_[i] > 0 ? (float)std::sqrt(sumR2 / count_[i]) : 0.0f;
+    }
+
+    // one allocation per attribute, each orbital's points are copied in at its offset
+    glBindBuffer(GL_ARRAY_BUFFER, positionVBO_);
+    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)totalPoints_ * sizeof(glm::vec3), nullptr, GL_STATIC_DRAW);
+    for (int i = 0; i < count; ++i) {
+        glBufferSubData(GL_ARRAY_BUFFER, first_[i] * sizeof(glm::vec3), count_[i] * sizeof(glm::vec3), points[i].data());
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, colorVBO_);
+    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)totalPoints_ * sizeof(glm::vec3), nullptr, GL_STATIC_DRAW);
+    for (int i = 0; i < count; ++i) {
+        glBufferSubData(GL_ARRAY_BUFFER, first_[i] * sizeof(glm::vec3), count_[i] * sizeof(glm::vec3), colors[i].data());
+    }
+    std::vector<GLuint> orbitalIndex(totalPoints_);
+    for (int i = 0; i < count; ++i) {
+        std::fill(orbitalIndex.begin() + first_[i], orbitalIndex.begin() + first_[i] + count_[i], (GLuint)i);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, orbitalVBO_);
+    glBufferData(GL_ARRAY_BUFFER, orbitalIndex.size() * sizeof(GLuint), orbitalIndex.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    setLayout(layout_);
+}
+
+void OrbitalComparison::setLayout(ComparisonLayout layout) {
+    layout_ = layout;
+    const int count = (int)first_.size();
+    placements_.assign(count, glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+
+    float maxRadius = 0.0f;
+    for (float r : radius_) maxRadius = std::max(maxRadius, r);
+    extent_ = maxRadius * 2.0f;
+    if (layout == ComparisonLayout::Overlay || count <= 1) return;
+
+    // most of a cloud lies within twice its RMS radius, cells are that wide plus a margin
+    float spacing = maxRadius * 4.5f;
+    int columns = (int)std::ceil(std::sqrt((float)count));
+    int rows = (count + columns - 1) / columns;
+    for (int i = 0; i < count; ++i) {
+        int column = i % columns;
+        int row = i / columns;
+        placements_[i].x = (column - (columns - 1) * 0.5f) * spacing;
+        placements_[i].y = ((rows - 1) * 0.5f - row) * spacing;
+    }
+    extent_ = std::sqrt((float)(columns * columns + rows * rows)) * spacing * 0.5f;
+}
+
+void OrbitalComparison::draw(const glm::mat4& model, float fraction, float pointSize, float alpha) {
+    const int count = (int)first_.size();
+    if (count == 0) return;
+
+    drawCount_.resize(count);
+    for (int i = 0; i < count; ++i) {
+        drawCount_[i] = std::min(count_[i], std::max((GLsizei)1, (GLsizei)(count_[i] * fraction)));
+    }
+
+    shader_.bind();
+    glUniformMatrix4fv(modelLoc_, 1, GL_FALSE, glm::value_ptr(model));
+    glUniform4fv(placementsLoc_, count, glm::value_ptr(placements_[0]));
+    glUniform1f(pointSizeLoc_, pointSize);
+    glUniform1f(alphaLoc_, alpha);
+    glBindVertexArray(vao_);
+    glMultiDrawArrays(GL_POINTS, first_.data(), drawCount_.data(), count);
+}
@@ -1,66 +1,319 @@
 #include "OrbitalGenerator.h"
+#include "Expectation.h"
 #include "hydrogen.h"
-#include <random>
+#include "LookupTable.h"
+#include "Random.h"
+#include "Trace.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cmath>
+#include <thread>
 #include <glm/gtc/type_ptr.hpp>
-#include <glad/glad.h> 
+#include <glad/glad.h>
 
 OrbitalGenerator::OrbitalGenerator(unsigned int orbitalVAO, unsigned int orbitalPosVBO, unsigned int orbitalColorVBO)
     : orbitalVAO_(orbitalVAO), orbitalPosVBO_(orbitalPosVBO), orbitalColorVBO_(orbitalColorVBO),
-      numOrbitalPoints_(0) {}
+      numOrbitalPoints_(0), trials_(50000), cloudRadius_(0.0f) {}
 
 void OrbitalGenerator::generateOrbital(const QuantumNumbers& qn) {
-    orbitalPoints_.clear();
-    orbitalColors_.clear();
-    Hydrogen h(qn.n, qn.m, qn.l, qn.s);
+    sample(qn);
+    upload();
+}
 
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_real_distribution<> dis(0.0, 1.0);
-
-    double max_r = qn.n * qn.n * 2.5;
-    double max_prob = 0.0;
-    for (int i = 0; i < 10000; ++i) {
-        double r = dis(gen) * max_r;
-        double theta = dis(gen) * 3.14159265;
-        double prob = std::pow(h.getR(r), 2) * std::pow(h.getTheta(theta), 2);
-        if (prob > max_prob) {
-            max_prob = prob;
-        }
+void OrbitalGenerator::sample(const QuantumNumbers& qn) {
+    if (adaptive_) {
+        adaptiveResult_ = AdaptiveSampler::sample(qn, orbitalPoints_, orbitalColors_, adaptiveTarget_, 0, options_);
+    } else {
+        sampleOrbital(qn, orbitalPoints_, orbitalColors_, trials_, 0, options_);
     }
-    if (max_prob == 0.0) max_prob = 1.0;
-
-    glm::vec3 color_up(0.2f, 0.5f, 1.0f);
-    glm::vec3 color_down(1.0f, 0.3f, 0.2f);
+    updateCloudRadius();
+}
 
-    for (int i = 0; i < 50000; ++i) {
-        double r = dis(gen) * max_r;
-        double theta = dis(gen) * 3.14159265;
-        double phi = dis(gen) * 2 * 3.14159265;
-
-        double prob = std::pow(h.getR(r), 2) * std::pow(h.getTheta(theta), 2);
-
-        if (prob / max_prob > dis(gen)) {
-            float x = (float)(r * sin(theta) * cos(phi));
-            float y = (float)(r * sin(theta) * sin(phi));
-            float z = (float)(r * cos(theta));
-            orbitalPoints_.push_back(glm::vec3(x, y, z));
-
-            if (qn.s == 1) {
-                orbitalColors_.push_back(color_up);
-            } else if (qn.s == -1) {
-                orbitalColors_.push_back(color_down);
-            } else { // qn.s == 0 (Both)
-                orbitalColors_.push_back((dis(gen) > 0.5) ? color_up : color_down);
-            }
-        }
+void OrbitalGenerator::sampleHybrid(const HybridSet& set) {
+    if (adaptive_) {
+        adaptiveResult_ = AdaptiveSampler::sample(set, orbitalPoints_, orbitalColors_, adaptiveTarget_, 0, options_.seed);
+    } else {
+        HybridOrbital::sample(set, orbitalPoints_, orbitalColors_, trials_, 0, options_.seed);
     }
+    updateCloudRadius();
+}
 
+void OrbitalGenerator::updateCloudRadius() {
     numOrbitalPoints_ = orbitalPoints_.size();
 
+    double sumR2 = 0.0;
+    for (const glm::vec3& p : orbitalPoints_) sumR2 += glm::dot(p, p);
+    cloudRadius_ = numOrbitalPoints_ > 0 ? (float)std::sqrt(sumR2 / numOrbitalPoints_) : 0.0f;
+}
+
+void OrbitalGenerator::upload() {
+    TRACE_SCOPE("upload");
+
     glBindVertexArray(orbitalVAO_);
     glBindBuffer(GL_ARRAY_BUFFER, orbitalPosVBO_);
     glBufferData(GL_ARRAY_BUFFER, orbitalPoints_.size() * sizeof(glm::vec3), orbitalPoints_.data(), GL_STATIC_DRAW);
     glBindBuffer(GL_ARRAY_BUFFER, orbitalColorVBO_);
     glBufferData(GL_ARRAY_BUFFER, orbitalColors_.size() * sizeof(glm::vec3), orbitalColors_.data(), GL_STATIC_DRAW);
 }
+
+static const size_t BLOCK = 256;
+
+// Density(r, theta, prob, count) fills prob with |psi|^2 for a block of candidates. Candidates
+// are uniform in (r, theta, phi), so the acceptance carries the volume element r^2 sin(theta).
+template <typename Density>
+static void sampleChunk(const Density& density, int s, double max_r, double max_prob, MathAccuracy accuracy, const Random& stream, int trials,
+                        std::vector<glm::vec3>& points, std::vector<glm::vec3>& colors) {
+    TRACE_SCOPE("sampleChunk");
+    Random gen = stream;
+
+    glm::vec3 color_up(0.2f, 0.5f, 1.0f);
+    glm::vec3 color_down(1.0f, 0.3f, 0.2f);
+
+    const float rScale = (float)max_r;
+    const float thetaScale = 3.14159265f;
+    const float phiScale = 2.0f * 3.14159265f;
+    const float probScale = (float)max_prob;
+    float r[BLOCK], theta[BLOCK], phi[BLOCK], prob[BLOCK], u[BLOCK];
+    float sinT[BLOCK], cosT[BLOCK], sinP[BLOCK], cosP[BLOCK];
+    for (int begin = 0; begin < trials; begin += (int)BLOCK) {
+        size_t block = std::min(BLOCK, (size_t)(trials - begin));
+        gen.fill(r, block);
+        gen.fill(theta, block);
+        gen.fill(phi, block);
+        gen.fill(u, block);
+        for (size_t i = 0; i < block; ++i) {
+            r[i] *= rScale;
+            theta[i] *= thetaScale;
+            phi[i] *= phiScale;
+        }
+        density(r, theta, prob, block);
+        VectorMath::sincos(theta, sinT, cosT, block, accuracy);
+
+        // keep the accepted candidates in place, then one transform for all of them
+        size_t accepted = 0;
+        for (size_t i = 0; i < block; ++i) {
+            if (prob[i] * r[i] * r[i] * sinT[i] > u[i] * probScale) {
+                r[accepted] = r[i];
+                sinT[accepted] = sinT[i];
+                cosT[accepted] = cosT[i];
+                phi[accepted] = phi[i];
+                ++accepted;
+            }
+        }
+        VectorMath::sincos(phi, sinP, cosP, accepted, accuracy);
+        for (size_t i = 0; i < accepted; ++i) {
+            points.push_back(glm::vec3(r[i] * sinT[i] * cosP[i], r[i] * sinT[i] * sinP[i], r[i] * cosT[i]));
+
+            if (s == 1) {
+                colors.push_back(color_up);
+            } else if (s == -1) {
+                colors.push_back(color_down);
+            } else { // s == 0 (Both)
+                colors.push_back((gen.next() > 0.5f) ? color_up : color_down);
+            }
+        }
+    }
+}
+
+template <typename Density>
+static void sampleDensity(const Density& density, const QuantumNumbers& qn, double max_r, MathAccuracy accuracy, uint64_t seed,
+                          std::vector<glm::vec3>& points, std::vector<glm::vec3>& colors, int trials, int maxThreads) {
+    Random gen(seed);
+
+    // Largest |psi|^2 r^2 sin(theta). A bound that is too low clips the peak and biases the
+    // cloud, so rather than trust random candidates: the best of a random scan seeds a grid
+    // search along r and then theta, which finds the maximum since the density factors into
+    // f(r) g(theta). The margin covers the grid spacing and the evaluators' own error.
+    TRACE_BEGIN("estimateMaxProb");
+    auto weighted = [&density](std::vector<float>& r, std::vector<float>& theta, std::vector<float>& prob) {
+        for (size_t begin = 0; begin < prob.size(); begin += BLOCK) {
+            density(&r[begin], &theta[begin], &prob[begin], std::min(BLOCK, prob.size() - begin));
+        }
+        for (size_t i = 0; i < prob.size(); ++i) prob[i] *= r[i] * r[i] * std::sin(theta[i]);
+        return (size_t)(std::max_element(prob.begin(), prob.end()) - prob.begin());
+    };
+    const int scan = 10000;
+    std::vector<float> r(scan), theta(scan), prob(scan);
+    gen.fill(r.data(), r.size());
+    gen.fill(theta.data(), theta.size());
+    for (int i = 0; i < scan; ++i) {
+        r[i] *= (float)max_r;
+        theta[i] *= 3.14159265f;
+    }
+    size_t best = weighted(r, theta, prob);
+    float bestTheta = theta[best];
+    for (int i = 0; i < scan; ++i) {
+        r[i] = (float)(max_r * (i + 0.5) / scan);
+        theta[i] = bestTheta;
+    }
+    float bestR = r[weighted(r, theta, prob)];
+    for (int i = 0; i < scan; ++i) {
+        r[i] = bestR;
+        theta[i] = (float)(3.14159265 * (i + 0.5) / scan);
+    }
+    double max_prob = prob[weighted(r, theta, prob)] * 1.02;
+    TRACE_END();
+    if (max_prob == 0.0) max_prob = 1.0;
+
+    const int chunkSize = 1 << 16;
+    int chunks = (std::max(trials, 0) + chunkSize - 1) / chunkSize;
+    gen.longJump();
+    if (chunks <= 1) {
+        sampleChunk(density, qn.s, max_r, max_prob, accuracy, gen, trials, points, colors);
+        return;
+    }
+
+    // one non-overlapping stream per chunk
+    std::vector<Random> streams;
+    streams.reserve(chunks);
+    for (int c = 0; c < chunks; ++c) {
+        streams.push_back(gen);
+        gen.longJump();
+    }
+    std::vector<std::vector<glm::vec3>> chunkPoints(chunks);
+    std::vector<std::vector<glm::vec3>> chunkColors(chunks);
+
+    std::atomic<int> nextChunk(0);
+    auto worker = [&]() {
+        int c;
+        while ((c = nextChunk++) < chunks) {
+            int count = std::min(chunkSize, trials - c * chunkSize);
+            sampleChunk(density, qn.s, max_r, max_prob, accuracy, streams[c], count, chunkPoints[c], chunkColors[c]);
+        }
+    };
+
+    int threadCount = std::min(chunks, std::max(1, (int)std::thread::hardware_concurrency()));
+    if (maxThreads > 0) threadCount = std::min(threadCount, maxThreads);
+    std::vector<std::thread> threads;
+    for (int t = 1; t < threadCount; ++t) {
+        threads.emplace_back([&worker]() {
+            TRACE_THREAD_NAME("sampler");
+            worker();
+        });
+    }
+    worker();
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    TRACE_SCOPE("concatenate");
+    size_t total = 0;
+    for (const auto& chunk : chunkPoints) total += chunk.size();
+    points.reserve(total);
+    colors.reserve(total);
+    for (int c = 0; c < chunks; ++c) {
+        points.insert(points.end(), chunkPoints[c].begin(), chunkPoints[c].end());
+        colors.insert(colors.end(), chunkColors[c].begin(), chunkColors[c].end());
+    }
+}
+
+double OrbitalGenerator::samplingRadius(const QuantumNumbers& qn) {
+    return Expectation::get(qn)->samplingRadius;
+}
+
+void OrbitalGenerator::sampleOrbital(const QuantumNumbers& qn, std::vector<glm::vec3>& points, std::vector<glm::vec3>& colors, int trials, int maxThreads,
+                                     const SamplerOptions& options) {
+    TRACE_SCOPE("sampleOrbital");
+    points.clear();
+    colors.clear();
+
+    double max_r = samplingRadius(qn);
+    if (options.evaluator == OrbitalEvaluator::Table) {
+        std::shared_ptr<const OrbitalTables> tables = OrbitalTables::get(qn, max_r, options.tableError);
+        const LookupTable& radial = tables->radial;
+        const LookupTable& polar = tables->polar;
+        auto density = [&radial, &polar](const float* r, const float* theta, float* prob, size_t count) {
+            for (size_t i = 0; i < count; ++i) {
+                double R = radial(r[i]);
+                double T = polar(theta[i]);
+                prob[i] = (float)(R * R * T * T);
+            }
+        };
+        sampleDensity(density, qn, max_r, options.accuracy, options.seed, points, colors, trials, maxThreads);
+    } else if (options.evaluator == OrbitalEvaluator::Vector) {
+        const Hydrogen h(qn.n, qn.m, qn.l, qn.s);
+        const MathAccuracy accuracy = options.accuracy;
+        auto density = [&h, accuracy](const float* r, const float* theta, float* prob, size_t count) {
+            float T[BLOCK];
+            h.getR(r, prob, count, accuracy);
+            h.getTheta(theta, T, count, accuracy);
+            for (size_t i = 0; i < count; ++i) prob[i] = prob[i] * prob[i] * T[i] * T[i];
+        };
+        sampleDensity(density, qn, max_r, options.accuracy, options.seed, points, colors, trials, maxThreads);
+    } else {
+        Hydrogen h(qn.n, qn.m, qn.l, qn.s);
+        auto density = [&h](const float* r, const float* theta, float* prob, size_t count) {
+            for (size_t i = 0; i < count; ++i) prob[i] = (float)(std::pow(h.getR(r[i]), 2) * std::pow(h.getTheta(theta[i]), 2));
+        };
+        sampleDensity(density, qn, max_r, options.accuracy, options.seed, points, colors, trials, maxThreads);
+    }
+}
+
+OrbitalGenerator::EvaluatorBenchmark OrbitalGenerator::benchmarkEvaluators(const QuantumNumbers& qn, int trials, double tableError, MathAccuracy accuracy) {
+    TRACE_SCOPE("benchmarkEvaluators");
+    EvaluatorBenchmark result;
+    const double max_r = samplingRadius(qn);
+    std::shared_ptr<const OrbitalTables> tables = OrbitalTables::build(qn, max_r, tableError);
+    result.buildMs = (float)tables->buildMs;
+    result.tableSegments = tables->radial.getSegmentCount() + tables->polar.getSegmentCount();
+    result.tableError = (float)std::max(tables->radial.getMeasuredError(), tables->polar.getMeasuredError());
+
+    // the kernels alone, on the same candidates
+    Random gen(12345);
+    std::vector<float> r(trials), theta(trials);
+    gen.fill(r.data(), trials);
+    gen.fill(theta.data(), trials);
+    for (int i = 0; i < trials; ++i) {
+        r[i] *= (float)max_r;
+        theta[i] *= 3.14159265f;
+    }
+    Hydrogen h(qn.n, qn.m, qn.l, qn.s);
+    const LookupTable& radial = tables->radial;
+    const LookupTable& polar = tables->polar;
+    auto start = std::chrono::steady_clock::now();
+    double sum = 0.0;
+    for (int i = 0; i < trials; ++i) sum += std::pow(h.getR(r[i]), 2) * std::pow(h.getTheta(theta[i]), 2);
+    result.exactKernelMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < trials; ++i) {
+        double R = radial(r[i]);
+        double T = polar(theta[i]);
+        sum += R * R * T * T;
+    }
+    result.tableKernelMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    start = std::chrono::steady_clock::now();
+    float R[BLOCK], T[BLOCK];
+    for (int begin = 0; begin < trials; begin += (int)BLOCK) {
+        size_t block = std::min(BLOCK, (size_t)(trials - begin));
+        h.getR(&r[begin], R, block, accuracy);
+        h.getTheta(&theta[begin], T, block, accuracy);
+        for (size_t i = 0; i < block; ++i) sum += R[i] * R[i] * T[i] * T[i];
+    }
+    result.vectorKernelMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    result.kernelSum = sum;
+
+    // whole sampler on one thread, candidate generation included
+    std::vector<glm::vec3> points;
+    std::vector<glm::vec3> colors;
+    SamplerOptions table;
+    table.evaluator = OrbitalEvaluator::Table;
+    table.tableError = tableError;
+    table.accuracy = accuracy;
+    SamplerOptions exact;
+    exact.accuracy = accuracy;
+    SamplerOptions vector;
+    vector.evaluator = OrbitalEvaluator::Vector;
+    vector.accuracy = accuracy;
+    OrbitalTables::get(qn, max_r, tableError); // keep the build out of the timing
+    start = std::chrono::steady_clock::now();
+    sampleOrbital(qn, points, colors, trials, 1, exact);
+    result.exactSampleMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    start = std::chrono::steady_clock::now();
+    sampleOrbital(qn, points, colors, trials, 1, table);
+    result.tableSampleMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    start = std::chrono::steady_clock::now();
+    sampleOrbital(qn, points, colors, trials, 1, vector);
+    result.vectorSampleMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
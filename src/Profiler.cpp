@@ -0,0 +1,171 @@
+#include "Profiler.h"
+#include <algorithm>
+#include <cmath>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+
+static const float MISSING = std::numeric_limits<float>::quiet_NaN();
+
+Profiler::Stage& Profiler::findStage(const char* name, bool gpu) {
+    for (Stage& stage : stages_) {
+        if (stage.name == name) return stage;
+    }
+    stages_.emplace_back();
+    Stage& stage = stages_.back();
+    stage.name = name;
+    stage.gpu = gpu;
+    std::fill(stage.cpuMs, stage.cpuMs + HISTORY, MISSING);
+    std::fill(stage.gpuMs, stage.gpuMs + HISTORY, MISSING);
+    if (gpu) glGenQueries(2, stage.queries);
+    return stage;
+}
+
+void Profiler::collect(Stage& stage, int set) {
+    if (stage.queryFrame[set] < 0) return;
+    GLint available = 0;
+    glGetQueryObjectiv(stage.queries[set], GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available) return;
+
+    GLuint64 elapsed = 0;
+    glGetQueryObjectui64v(stage.queries[set], GL_QUERY_RESULT, &elapsed);
+    // the slot may already belong to a newer frame if the result took that long
+    if (frame_ - stage.queryFrame[set] < HISTORY) {
+        stage.gpuMs[stage.queryFrame[set] % HISTORY] = (float)(elapsed / 1.0e6);
+    }
+    stage.queryFrame[set] = -1;
+}
+
+void Profiler::beginFrame() {
+    if (!enabled_) return;
+    frame_++;
+    if (frame_ == 0) std::fill(frameMs_, frameMs_ + HISTORY, MISSING);
+    int slot = (int)(frame_ % HISTORY);
+    frameMs_[slot] = MISSING;
+
+    for (Stage& stage : stages_) {
+        stage.cpuMs[slot] = MISSING;
+        stage.gpuMs[slot] = MISSING;
+        if (stage.gpu) {
+            collect(stage, 0);
+            collect(stage, 1);
+        }
+    }
+    frameStart_ = std::chrono::steady_clock::now();
+}
+
+void Profiler::endFrame() {
+    if (!enabled_ || frame_ < 0) return;
+    frameMs_[frame_ % HISTORY] = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - frameStart_).count();
+}
+
+void Profiler::begin(const char* name, bool gpu) {
+    if (!enabled_ || frame_ < 0) return;
+    Stage& stage = findStage(name, gpu);
+    if (stage.depth++ > 0) return;
+    stage.cpuStart = std::chrono::steady_clock::now();
+
+    // a stage entered twice in a frame only times the first entry on the GPU; a query
+    // still unresolved from two frames ago is dropped by reusing it
+    int set = (int)(frame_ & 1);
+    if (stage.gpu && !gpuActive_ && stage.queryFrame[set] != frame_) {
+        glBeginQuery(GL_TIME_ELAPSED, stage.queries[set]);
+        stage.queryFrame[set] = frame_;
+        stage.ownsQuery = true;
+        gpuActive_ = true;
+    }
+}
+
+void Profiler::end(const char* name) {
+    if (!enabled_ || frame_ < 0) return;
+    Stage& stage = findStage(name, true);
+    if (stage.depth == 0 || --stage.depth > 0) return;
+
+    float ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - stage.cpuStart).count();
+    float& cpu = stage.cpuMs[frame_ % HISTORY];
+    cpu = std::isnan(cpu) ? ms : cpu + ms;
+
+    if (stage.ownsQuery) {
+        glEndQuery(GL_TIME_ELAPSED);
+        stage.ownsQuery = false;
+        gpuActive_ = false;
+    }
+}
+
+void Profiler::clear() {
+    for (Stage& stage : stages_) {
+        if (stage.gpu) glDeleteQueries(2, stage.queries);
+    }
+    stages_.clear();
+    frame_ = -1;
+    gpuActive_ = false;
+}
+
+void Profiler::getHistory(const float* ring, float* out) const {
+    for (int i = 0; i < HISTORY; ++i) {
+        long long frame = frame_ - HISTORY + 1 + i;
+        float value = frame >= 0 ? ring[frame % HISTORY] : MISSING;
+        out[i] = std::isnan(value) ? 0.0f : value;
+    }
+}
+
+Profiler::Percentiles Profiler::getPercentiles(const float* ring) const {
+    float values[HISTORY];
+    int count = 0;
+    int frames = (int)std::min<long long>(frame_ + 1, HISTORY);
+    for (int i = 0; i < frames; ++i) {
+        if (!std::isnan(ring[i])) values[count++] = ring[i];
+    }
+
+    Percentiles result;
+    if (count == 0) return result;
+    auto percentile = [&](float p) {
+        int k = std::min(count - 1, (int)std::ceil(p * count) - 1);
+        std::nth_element(values, values + std::max(k, 0), values + count);
+        return values[std::max(k, 0)];
+    };
+    result.p50 = percentile(0.50f);
+    result.p95 = percentile(0.95f);
+    result.p99 = percentile(0.99f);
+    return result;
+}
+
+bool Profiler::exportCsv(const std::string& path) const {
+    std::ofstream file(path);
+    if (!file) return false;
+
+    file << "frame,frame_cpu_ms";
+    for (const Stage& stage : stages_) {
+        file << "," << stage.name << "_cpu_ms";
+        if (stage.gpu) file << "," << stage.name << "_gpu_ms";
+    }
+    file << "\n";
+
+    // empty fields are stages that did not run that frame or GPU results not back yet
+    auto field = [&](float value) {
+        file << ",";
+        if (!std::isnan(value)) file << value;
+    };
+    long long first = std::max(0LL, frame_ - HISTORY + 1);
+    for (long long frame = first; frame <= frame_; ++frame) {
+        int slot = (int)(frame % HISTORY);
+        file << frame;
+        field(frameMs_[slot]);
+        for (const Stage& stage : stages_) {
+            field(stage.cpuMs[slot]);
+            if (stage.gpu) field(stage.gpuMs[slot]);
+        }
+        file << "\n";
+    }
+    return (bool)file;
+}
+
+std::string Profiler::exportCsv() const {
+    std::time_t now = std::time(nullptr);
+    char name[64];
+    std::strftime(name, sizeof(name), "captures/profile_%Y%m%d_%H%M%S.csv", std::localtime(&now));
+    std::error_code ec;
+    std::filesystem::create_directories("captures", ec);
+    return exportCsv(name) ? name : "";
+}
@@ -0,0 +1,65 @@
+#include "Quadrature.h"
+#include <cmath>
+
+namespace Quadrature {
+
+// Nodes by Newton's method on the three term recurrence, started from asymptotic guesses
+// (Numerical Recipes, gaulag and gauleg with alpha = 0)
+void gaussLaguerre(int count, std::vector<double>& x, std::vector<double>& w) {
+    x.assign(count, 0.0);
+    w.assign(count, 0.0);
+    double z = 0.0;
+    for (int i = 0; i < count; ++i) {
+        if (i == 0) {
+            z = 3.0 / (1.0 + 2.4 * count);
+        } else if (i == 1) {
+            z += 15.0 / (1.0 + 2.5 * count);
+        } else {
+            double ai = i - 1;
+            z += (1.0 + 2.55 * ai) / (1.9 * ai) * (z - x[i - 2]);
+        }
+        double p1 = 1.0, p2 = 0.0, derivative = 1.0;
+        for (int iteration = 0; iteration < 100; ++iteration) {
+            p1 = 1.0;
+            p2 = 0.0;
+            for (int j = 1; j <= count; ++j) {
+                double p3 = p2;
+                p2 = p1;
+                p1 = ((2 * j - 1 - z) * p2 - (j - 1) * p3) / j;
+            }
+            derivative = (count * p1 - count * p2) / z;
+            double previous = z;
+            z = previous - p1 / derivative;
+            if (std::fabs(z - previous) <= 1e-15 * z) break;
+        }
+        x[i] = z;
+        w[i] = -1.0 / (derivative * count * p2);
+    }
+}
+
+void gaussLegendre(int count, std::vector<double>& x, std::vector<double>& w) {
+    const double PI = 3.14159265358979323846;
+    x.assign(count, 0.0);
+    w.assign(count, 0.0);
+    for (int i = 0; i < (count + 1) / 2; ++i) {
+        double z = std::cos(PI * (i + 0.75) / (count + 0.5));
+        double derivative = 1.0;
+        for (int iteration = 0; iteration < 100; ++iteration) {
+            double p1 = 1.0, p2 = 0.0;
+            for (int j = 1; j <= count; ++j) {
+                double p3 = p2;
+                p2 = p1;
+                p1 = ((2 * j - 1) * z * p2 - (j - 1) * p3) / j;
+            }
+            derivative = count * (z * p1 - p2) / (z * z - 1.0);
+            double previous = z;
+            z = previous - p1 / derivative;
+            if (std::fabs(z - previous) <= 1e-15) break;
+        }
+        x[i] = -z;
+        x[count - 1 - i] = z;
+        w[i] = w[count - 1 - i] = 2.0 / ((1.0 - z * z) * derivative * derivative);
+    }
+}
+
+} // namespace Quadrature
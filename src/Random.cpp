@@ -0,0 +1,125 @@
+#include "Random.h"
+#include "Simd.h"
+#include <cstring>
+
+static uint64_t splitMix64(uint64_t& x) {
+    uint64_t z = (x += 0x9e3779b97f4a7c15ull);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+}
+
+// jump polynomials from the xoshiro128+ reference implementation
+static const uint32_t JUMP[4] = {0x8764000b, 0xf542d2d3, 0x6fa035c3, 0x77f2db5b};
+static const uint32_t LONG_JUMP[4] = {0xb523952e, 0x0b6f099f, 0xccf5a0ef, 0x1c580662};
+
+Random::Random(uint64_t seed) {
+    uint64_t x = seed;
+    uint64_t a = splitMix64(x);
+    uint64_t b = splitMix64(x);
+    uint32_t lane[4] = {(uint32_t)a, (uint32_t)(a >> 32), (uint32_t)b, (uint32_t)(b >> 32)};
+
+    // lane k starts k jumps after lane 0
+    for (int k = 0; k < LANES; ++k) {
+        for (int w = 0; w < 4; ++w) state_[w][k] = lane[w];
+        uint32_t s[4] = {0, 0, 0, 0};
+        for (int i = 0; i < 4; ++i) {
+            for (int bit = 0; bit < 32; ++bit) {
+                if (JUMP[i] & (1u << bit)) {
+                    for (int w = 0; w < 4; ++w) s[w] ^= lane[w];
+                }
+                uint32_t t = lane[1] << 9;
+                lane[2] ^= lane[0];
+                lane[3] ^= lane[1];
+                lane[1] ^= lane[2];
+                lane[0] ^= lane[3];
+                lane[2] ^= t;
+                lane[3] = (lane[3] << 11) | (lane[3] >> 21);
+            }
+        }
+        std::memcpy(lane, s, sizeof(lane));
+    }
+}
+
+uint64_t Random::derive(uint64_t seed, uint64_t index) {
+    uint64_t x = seed ^ (index * 0xd1b54a32d192ed03ull);
+    return splitMix64(x);
+}
+
+void Random::step(float* out, size_t steps) {
+    using Simd::Int;
+    // one group of lanes at a time so its state stays in registers
+    for (int g = 0; g < LANES; g += Simd::WIDTH) {
+        Int s0 = Simd::load(&state_[0][g]);
+        Int s1 = Simd::load(&state_[1][g]);
+        Int s2 = Simd::load(&state_[2][g]);
+        Int s3 = Simd::load(&state_[3][g]);
+        for (size_t i = 0; i < steps; ++i) {
+            Int result = s0 + s3;
+            Int t = s1 << 9;
+            s2 = s2 ^ s0;
+            s3 = s3 ^ s1;
+            s1 = s1 ^ s2;
+            s0 = s0 ^ s3;
+            s2 = s2 ^ t;
+            s3 = (s3 << 11) | Simd::shiftRight(s3, 21);
+
+            // top 23 bits as the mantissa of a float in [1, 2)
+            Simd::Float f = Simd::asFloat(Simd::shiftRight(result, 9) | Simd::set(0x3f800000));
+            Simd::store(out + i * LANES + g, f - Simd::set(1.0f));
+        }
+        Simd::store(&state_[0][g], s0);
+        Simd::store(&state_[1][g], s1);
+        Simd::store(&state_[2][g], s2);
+        Simd::store(&state_[3][g], s3);
+    }
+}
+
+void Random::fill(float* out, size_t count) {
+    while (count > 0 && buffered_ > 0) {
+        *out++ = buffer_[LANES - buffered_--];
+        --count;
+    }
+    size_t steps = count / LANES;
+    step(out, steps);
+    out += steps * LANES;
+    count -= steps * LANES;
+    if (count > 0) {
+        step(buffer_, 1);
+        buffered_ = LANES;
+        while (count-- > 0) *out++ = buffer_[LANES - buffered_--];
+    }
+}
+
+float Random::next() {
+    if (buffered_ == 0) {
+        step(buffer_, 1);
+        buffered_ = LANES;
+    }
+    return buffer_[LANES - buffered_--];
+}
+
+void Random::jumpLanes(const uint32_t* polynomial) {
+    uint32_t s[4][LANES] = {};
+    float scratch[LANES];
+    for (int i = 0; i < 4; ++i) {
+        for (int bit = 0; bit < 32; ++bit) {
+            if (polynomial[i] & (1u << bit)) {
+                for (int w = 0; w < 4; ++w) {
+                    for (int k = 0; k < LANES; ++k) s[w][k] ^= state_[w][k];
+                }
+            }
+            step(scratch, 1);
+        }
+    }
+    std::memcpy(state_, s, sizeof(s));
+    buffered_ = 0;
+}
+
+void Random::jump() {
+    jumpLanes(JUMP);
+}
+
+void Random::longJump() {
+    jumpLanes(LONG_JUMP);
+}
@@ -0,0 +1,27 @@
+#include "RedrawScheduler.h"
+#include <algorithm>
+
+void RedrawScheduler::invalidate(unsigned reasons, int frames) {
+    pendingReasons_ |= reasons;
+    framesLeft_ = std::max(framesLeft_, frames);
+}
+
+unsigned RedrawScheduler::beginFrame() {
+    framesRendered_++;
+    lastReasons_ = pendingReasons_;
+    if (framesLeft_ > 0) framesLeft_--;
+    if (framesLeft_ == 0) pendingReasons_ = 0;
+    return lastReasons_;
+}
+
+const char* RedrawScheduler::reasonName(Reason reason) {
+    switch (reason) {
+    case Camera: return "camera";
+    case Orbital: return "orbital";
+    case Interface: return "interface";
+    case Animation: return "animation";
+    case Progressive: return "progressive";
+    case Window: return "window";
+    }
+    return "unknown";
+}
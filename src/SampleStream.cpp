@@ -0,0 +1,93 @@
+#include "SampleStream.h"
+#include "OrbitalGenerator.h"
+#include "Trace.h"
+
+SampleStream::SampleStream() {
+    thread_ = std::thread(&SampleStream::run, this);
+}
+
+SampleStream::~SampleStream() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    wake_.notify_all();
+    thread_.join();
+}
+
+void SampleStream::setSource(const QuantumNumbers& qn, int trials, const SamplerOptions& options) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        qn_ = qn;
+        options_ = options;
+        isHybrid_ = false;
+        trials_ = trials;
+        hasSource_ = true;
+        ready_ = false;
+        generation_++;
+        batch_ = 0;
+    }
+    wake_.notify_all();
+}
+
+void SampleStream::setSource(const HybridSet& set, int trials, uint64_t seed) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        hybrid_ = set;
+        options_.seed = seed;
+        isHybrid_ = true;
+        trials_ = trials;
+        hasSource_ = true;
+        ready_ = false;
+        generation_++;
+        batch_ = 0;
+    }
+    wake_.notify_all();
+}
+
+bool SampleStream::fetch(std::vector<glm::vec3>& points, std::vector<glm::vec3>& colors) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!ready_) return false;
+        points.swap(readyPoints_);
+        colors.swap(readyColors_);
+        ready_ = false;
+    }
+    wake_.notify_all();
+    return true;
+}
+
+void SampleStream::run() {
+    TRACE_THREAD_NAME("sample stream");
+    std::vector<glm::vec3> points;
+    std::vector<glm::vec3> colors;
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        wake_.wait(lock, [this] { return stop_ || (hasSource_ && !ready_); });
+        if (stop_) return;
+
+        QuantumNumbers qn = qn_;
+        SamplerOptions options = options_;
+        HybridSet hybrid = hybrid_;
+        bool isHybrid = isHybrid_;
+        int trials = trials_;
+        unsigned int generation = generation_;
+        options.seed = Random::derive(options.seed, ++batch_);
+        lock.unlock();
+
+        if (isHybrid) {
+            HybridOrbital::sample(hybrid, points, colors, trials, 0, options.seed);
+        } else {
+            OrbitalGenerator::sampleOrbital(qn, points, colors, trials, 0, options);
+        }
+
+        lock.lock();
+        // the state changed while sampling, that batch belongs to the old orbital
+        if (generation == generation_) {
+            readyPoints_.swap(points);
+            readyColors_.swap(colors);
+            ready_ = true;
+        }
+    }
+}
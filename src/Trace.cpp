@@ -0,0 +1,184 @@
+#include "Trace.h"
+
+#ifdef HYDROGEN_TRACING
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Trace {
+
+static const size_t CAPACITY = 1 << 16; // events per thread buffer, power of two
+
+struct Event {
+    const char* name; // nullptr for an end event
+    unsigned long long timestampNs;
+    int tid;
+};
+
+// dump reads a slot while its owner may be overwriting it, so every field is a relaxed atomic
+struct Slot {
+    std::atomic<const char*> name;
+    std::atomic<unsigned long long> timestampNs;
+    std::atomic<int> tid;
+};
+
+struct Buffer {
+    Slot events[CAPACITY];
+    std::atomic<unsigned long long> head{0}; // total events written, only the owner advances it
+};
+
+struct Registry {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<Buffer>> buffers;
+    std::vector<Buffer*> freeBuffers;
+    std::vector<std::pair<int, std::string>> threadNames;
+    int nextTid = 1;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+};
+
+static Registry& registry() {
+    static Registry instance;
+    return instance;
+}
+
+// returns the buffer to the pool when its thread exits, the events in it stay readable
+struct ThreadState {
+    Buffer* buffer = nullptr;
+    int tid = 0;
+
+    ~ThreadState() {
+        if (!buffer) return;
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        r.freeBuffers.push_back(buffer);
+    }
+};
+
+static thread_local ThreadState threadState;
+
+static ThreadState& state() {
+    ThreadState& s = threadState;
+    if (s.buffer) return s;
+
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    if (!r.freeBuffers.empty()) {
+        s.buffer = r.freeBuffers.back();
+        r.freeBuffers.pop_back();
+    } else {
+        r.buffers.emplace_back(new Buffer());
+        s.buffer = r.buffers.back().get();
+    }
+    s.tid = r.nextTid++;
+    return s;
+}
+
+static void record(const char* name) {
+    ThreadState& s = state();
+    unsigned long long now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - registry().start).count();
+
+    Buffer& buffer = *s.buffer;
+    unsigned long long head = buffer.head.load(std::memory_order_relaxed);
+    Slot& slot = buffer.events[head & (CAPACITY - 1)];
+    slot.name.store(name, std::memory_order_relaxed);
+    slot.timestampNs.store(now, std::memory_order_relaxed);
+    slot.tid.store(s.tid, std::memory_order_relaxed);
+    buffer.head.store(head + 1, std::memory_order_release);
+}
+
+void begin(const char* name) {
+    record(name);
+}
+
+void end() {
+    record(nullptr);
+}
+
+void setThreadName(const char* name) {
+    ThreadState& s = state();
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    r.threadNames.emplace_back(s.tid, name);
+}
+
+static void writeString(std::ofstream& file, const char* text) {
+    file << '"';
+    for (const char* c = text; *c; ++c) {
+        if (*c == '"' || *c == '\\') file << '\\';
+        file << *c;
+    }
+    file << '"';
+}
+
+bool dump(const std::string& path) {
+    std::ofstream file(path);
+    if (!file) return false;
+
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+
+    file << "{\"traceEvents\":[\n";
+    bool first = true;
+    for (const auto& thread : r.threadNames) {
+        file << (first ? "" : ",\n") << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":" << thread.first << ",\"args\":{\"name\":";
+        writeString(file, thread.second.c_str());
+        file << "}}";
+        first = false;
+    }
+
+    std::vector<Event> events;
+    for (const auto& buffer : r.buffers) {
+        // copy without stopping the writer, then drop whatever it may have overwritten meanwhile
+        unsigned long long head = buffer->head.load(std::memory_order_acquire);
+        unsigned long long begin = head > CAPACITY ? head - CAPACITY : 0;
+        events.resize((size_t)(head - begin));
+        for (unsigned long long i = begin; i < head; ++i) {
+            const Slot& slot = buffer->events[i & (CAPACITY - 1)];
+            events[(size_t)(i - begin)] = {slot.name.load(std::memory_order_relaxed), slot.timestampNs.load(std::memory_order_relaxed),
+                                           slot.tid.load(std::memory_order_relaxed)};
+        }
+        // keeps the copy from moving past the second head load, as in a seqlock read
+        std::atomic_thread_fence(std::memory_order_acquire);
+        // event headAfter may be half written into the slot of headAfter - CAPACITY, drop that one too
+        unsigned long long headAfter = buffer->head.load(std::memory_order_acquire);
+        unsigned long long firstIntact = headAfter + 1 > CAPACITY ? headAfter + 1 - CAPACITY : 0;
+        size_t skip = firstIntact > begin ? (size_t)(firstIntact - begin) : 0;
+
+        char timestamp[32];
+        for (size_t i = skip; i < events.size(); ++i) {
+            const Event& event = events[i];
+            // microseconds with ns precision
+            snprintf(timestamp, sizeof(timestamp), "%llu.%03llu", event.timestampNs / 1000, event.timestampNs % 1000);
+            file << (first ? "" : ",\n") << "{\"ph\":\"" << (event.name ? 'B' : 'E') << "\",\"pid\":1,\"tid\":" << event.tid << ",\"ts\":" << timestamp;
+            if (event.name) {
+                file << ",\"name\":";
+                writeString(file, event.name);
+            }
+            file << "}";
+            first = false;
+        }
+    }
+    file << "\n]}\n";
+    return (bool)file;
+}
+
+std::string dump() {
+    std::time_t now = std::time(nullptr);
+    char name[64];
+    std::strftime(name, sizeof(name), "captures/trace_%Y%m%d_%H%M%S.json", std::localtime(&now));
+    std::error_code ec;
+    std::filesystem::create_directories("captures", ec);
+    return dump(name) ? name : "";
+}
+
+} // namespace Trace
+
+#endif // HYDROGEN_TRACING
@@ -0,0 +1,93 @@
+#include "TransitionTable.h"
+#include "hydrogen.h"
+#include "Quadrature.h"
+#include "Trace.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <thread>
+#include <utility>
+
+static const double RYDBERG_WAVELENGTH_NM = 91.1267050; // 1 / R_infinity
+static const double SPEED_OF_LIGHT = 137.035999; // atomic units
+static const double TIME_UNIT_S = 2.4188843265857e-17;
+
+const char* TransitionTable::seriesName(int nLower) {
+    static const char* names[] = {"Lyman", "Balmer", "Paschen", "Brackett", "Pfund", "Humphreys"};
+    return nLower >= 1 && nLower <= 6 ? names[nLower - 1] : "";
+}
+
+void TransitionTable::build(int nMax, int maxThreads) {
+    nMax = std::max(nMax, 2);
+    if (nMax == nMax_) return;
+    TRACE_SCOPE("transitionTable");
+    auto start = std::chrono::steady_clock::now();
+    nMax_ = nMax;
+    states_ = stateIndex(nMax + 1, 0);
+    radial_.assign((size_t)states_ * states_, 0.0);
+
+    // r^3 R R' has degree at most 2 nMax + 1 in r once the exponentials go into the weight
+    std::vector<double> x, w;
+    Quadrature::gaussLaguerre(nMax + 2, x, w);
+    for (size_t i = 0; i < x.size(); ++i) w[i] *= x[i] * x[i] * x[i];
+
+    std::vector<std::pair<int, int>> blocks;
+    for (int n1 = 1; n1 <= nMax; ++n1) {
+        for (int n2 = n1; n2 <= nMax; ++n2) blocks.emplace_back(n1, n2);
+    }
+    std::atomic<int> nextBlock(0);
+    auto worker = [&]() {
+        std::vector<double> r(x.size());
+        std::vector<double> P1(nMax * x.size()), P2(nMax * x.size());
+        int b;
+        while ((b = nextBlock++) < (int)blocks.size()) {
+            const int n1 = blocks[b].first, n2 = blocks[b].second;
+            // e^(-r/n1) e^(-r/n2) = e^(-x) with x = beta r
+            const double beta = 1.0 / n1 + 1.0 / n2;
+            for (size_t i = 0; i < x.size(); ++i) r[i] = x[i] / beta;
+            // every l of both shells on the shared nodes, one batch per radial function
+            for (int l = 0; l < n1; ++l) Hydrogen::radialPolynomial(n1, l, r.data(), &P1[l * x.size()], x.size());
+            for (int l = 0; l < n2; ++l) Hydrogen::radialPolynomial(n2, l, r.data(), &P2[l * x.size()], x.size());
+            const double scale = std::pow(beta, -4.0);
+            for (int l1 = 0; l1 < n1; ++l1) {
+                for (int l2 = std::max(l1 - 1, 0); l2 <= std::min(l1 + 1, n2 - 1); ++l2) {
+                    if (l2 == l1) continue;
+                    double sum = 0.0;
+                    for (size_t i = 0; i < x.size(); ++i) sum += w[i] * P1[l1 * x.size() + i] * P2[l2 * x.size() + i];
+                    int a = stateIndex(n1, l1), c = stateIndex(n2, l2);
+                    radial_[(size_t)a * states_ + c] = radial_[(size_t)c * states_ + a] = sum * scale;
+                }
+            }
+        }
+    };
+    int threadCount = std::min((int)blocks.size(), std::max(1, (int)std::thread::hardware_concurrency()));
+    if (maxThreads > 0) threadCount = std::min(threadCount, maxThreads);
+    std::vector<std::thread> threads;
+    for (int t = 1; t < threadCount; ++t) threads.emplace_back(worker);
+    worker();
+    for (auto& t : threads) t.join();
+
+    // the l-summed line of every pair of shells: S = sum over l, l' = l +- 1 of max(l, l') R^2
+    lines_.clear();
+    for (int lower = 1; lower < nMax; ++lower) {
+        for (int upper = lower + 1; upper <= nMax; ++upper) {
+            double S = 0.0;
+            for (int l = 0; l < lower; ++l) {
+                for (int lu = std::max(l - 1, 0); lu <= std::min(l + 1, upper - 1); ++lu) {
+                    if (lu != l) S += std::max(l, lu) * std::pow(radial(lower, l, upper, lu), 2);
+                }
+            }
+            double energy = 0.5 * (1.0 / (lower * lower) - 1.0 / (upper * upper)); // Hartree
+            SpectralLine line;
+            line.nUpper = upper;
+            line.nLower = lower;
+            line.wavelengthNm = RYDBERG_WAVELENGTH_NM / (2.0 * energy);
+            line.lineStrength = S;
+            line.oscillatorStrength = 2.0 / 3.0 * energy * S / (lower * lower);
+            line.einsteinA = 4.0 / 3.0 * std::pow(energy, 3) * S / (std::pow(SPEED_OF_LIGHT, 3) * upper * upper) / TIME_UNIT_S;
+            lines_.push_back(line);
+        }
+    }
+    buildMs_ = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
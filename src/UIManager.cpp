@@ -1,6 +1,31 @@
 #include "UIManager.h"
+#include <openglDebug.h>
+#include "Expectation.h"
+#include "HybridOrbital.h"
+#include "RedrawScheduler.h"
+#include "Simd.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
 
-void UIManager::drawUI(QuantumNumbers& qn, bool& orbitalNeedsUpdate) {
+struct NucleusPreset {
+    const char* name;
+    double Z;
+    double particleMass; // electron masses
+    double nucleusMass;  // electron masses, 0 = infinitely heavy
+};
+
+static const NucleusPreset NUCLEUS_PRESETS[] = {
+    {"H (fixed nucleus)", 1.0, 1.0, 0.0},
+    {"H", 1.0, 1.0, 1836.15267},
+    {"He+", 2.0, 1.0, 7294.29954},
+    {"Li2+", 3.0, 1.0, 12786.3933},
+    {"Muonic H", 1.0, 206.768283, 1836.15267},
+    {"Positronium", 1.0, 1.0, 1.0},
+};
+
+void UIManager::drawUI(QuantumNumbers& qn, Nucleus& nucleus, bool& orbitalNeedsUpdate) {
     ImGui::Begin("Controls");
     ImGui::Text("Quantum Numbers");
     if (ImGui::SliderInt("n", &qn.n, 1, 4)) orbitalNeedsUpdate = true;
@@ -16,5 +41,531 @@ void UIManager::drawUI(QuantumNumbers& qn, bool& orbitalNeedsUpdate) {
     if (ImGui::RadioButton("Down", &qn.s, -1)) orbitalNeedsUpdate = true;
     ImGui::SameLine();
     if (ImGui::RadioButton("Both", &qn.s, 0)) orbitalNeedsUpdate = true;
+
+    // the cloud is sampled once for Z = 1, a different nucleus only rescales it
+    ImGui::Separator();
+    ImGui::Text("Nucleus");
+    if (ImGui::BeginCombo("Preset", "Choose...")) {
+        for (const NucleusPreset& preset : NUCLEUS_PRESETS) {
+            if (ImGui::Selectable(preset.name)) {
+                nucleus.Z = preset.Z;
+                nucleus.reducedMass = preset.nucleusMass > 0.0 ? Nucleus::reducedMassOf(preset.particleMass, preset.nucleusMass) : preset.particleMass;
+            }
+        }
+        ImGui::EndCombo();
+    }
+    int Z = (int)nucleus.Z;
+    if (ImGui::SliderInt("Z", &Z, 1, 10)) nucleus.Z = Z;
+    ImGui::InputDouble("Reduced mass", &nucleus.reducedMass, 0.0, 0.0, "%.5f");
+    nucleus.reducedMass = std::max(nucleus.reducedMass, 1e-3);
+    ImGui::Text("Length scale %.4g a0", nucleus.lengthScale());
+    ImGui::End();
+}
+
+void UIManager::drawCaptureUI(FrameCapture& capture) {
+    ImGui::Begin("Capture");
+    FrameWriter& writer = capture.getWriter();
+    int format = writer.getFormat() == FrameFormat::PNG ? 0 : 1;
+    if (ImGui::RadioButton("PNG", &format, 0)) writer.setFormat(FrameFormat::PNG);
+    ImGui::SameLine();
+    if (ImGui::RadioButton("Raw", &format, 1)) writer.setFormat(FrameFormat::Raw);
+
+    if (ImGui::Button("Screenshot")) capture.requestScreenshot();
+    ImGui::SameLine();
+    if (capture.isRecording()) {
+        if (ImGui::Button("Stop recording")) capture.stopRecording();
+    } else {
+        if (ImGui::Button("Record")) capture.startRecording();
+    }
+
+    ImGui::Separator();
+    ImGui::Text("Queue depth: %d / %d", (int)writer.getQueueDepth(), (int)writer.getMaxQueued());
+    ImGui::Text("Readbacks in flight: %d / %d", capture.getPendingReadbacks(), FrameCapture::RING_SIZE);
+    ImGui::Text("Captured: %d  Written: %d", (int)capture.getFramesCaptured(), (int)writer.getFramesWritten());
+    ImGui::Text("Dropped: %d", (int)capture.getFramesDropped());
+    if (!capture.getLastPath().empty()) ImGui::TextDisabled("%s", capture.getLastPath().c_str());
+    ImGui::End();
+}
+
+void UIManager::drawRenderUI(RenderSettings& settings, const RenderStats& stats, const QuantumNumbers& qn, bool& orbitalNeedsUpdate) {
+    ImGui::Begin("Rendering");
+    int mode = (int)settings.mode;
+    if (ImGui::RadioButton("Points", &mode, (int)RenderMode::Points)) settings.mode = RenderMode::Points;
+    ImGui::SameLine();
+    if (ImGui::RadioButton("Density", &mode, (int)RenderMode::Density)) settings.mode = RenderMode::Density;
+    if (settings.mode == RenderMode::Density) {
+        ImGui::SliderFloat("Exposure", &settings.exposure, 0.01f, 100.0f, "%.2f", ImGuiSliderFlags_Logarithmic);
+        ImGui::Checkbox("Progressive refinement", &settings.progressive);
+        if (settings.progressive) {
+            ImGui::SliderInt("Batches", &settings.progressiveFrames, 1, 1024, "%d", ImGuiSliderFlags_Logarithmic);
+            ImGui::Text("Accumulated %d / %d", stats.accumulatedFrames, settings.progressiveFrames);
+        }
+    } else {
+        ImGui::SliderFloat("Opacity", &settings.pointAlpha, 0.01f, 1.0f);
+        if (settings.pointAlpha < 1.0f) {
+            ImGui::Text("Depth sort: %.1f ms (%s)", stats.lastSortMs, stats.lastSortIncremental ? "incremental" : "radix");
+        }
+    }
+
+    // resampling millions of points on every drag step would stall, wait for the release
+    if (ImGui::Checkbox("Adaptive count", &settings.adaptive)) orbitalNeedsUpdate = true;
+    if (settings.adaptive) {
+        float histogramError = (float)settings.adaptiveTarget.histogramError;
+        if (ImGui::SliderFloat("Histogram error", &histogramError, 1e-3f, 0.1f, "%.3f", ImGuiSliderFlags_Logarithmic)) {
+            settings.adaptiveTarget.histogramError = histogramError;
+        }
+        if (ImGui::IsItemDeactivatedAfterEdit()) orbitalNeedsUpdate = true;
+        float momentError = (float)settings.adaptiveTarget.momentError;
+        if (ImGui::SliderFloat("Moment error", &momentError, 1e-4f, 0.05f, "%.4f", ImGuiSliderFlags_Logarithmic)) {
+            settings.adaptiveTarget.momentError = momentError;
+        }
+        if (ImGui::IsItemDeactivatedAfterEdit()) orbitalNeedsUpdate = true;
+        const AdaptiveResult& a = stats.adaptive;
+        if (a.rounds > 0) {
+            ImGui::Text("%d points in %d rounds, %.0f ms%s", (int)a.points, a.rounds, a.ms, a.converged ? "" : " (point cap)");
+            ImGui::Text("<r> %.3f +- %.3f  <r2> %.2f +- %.2f", a.meanR, a.meanRError, a.meanR2, a.meanR2Error);
+            ImGui::Text("Histogram error %.4f", a.histogramError);
+        }
+    } else {
+        ImGui::SliderInt("Trials", &settings.trials, 10000, 50000000, "%d", ImGuiSliderFlags_Logarithmic);
+        if (ImGui::IsItemDeactivatedAfterEdit()) orbitalNeedsUpdate = true;
+    }
+    ImGui::Checkbox("True size", &settings.trueScale);
+
+    int evaluator = (int)settings.sampler.evaluator;
+    ImGui::Text("Evaluator");
+    ImGui::SameLine();
+    if (ImGui::RadioButton("Exact", &evaluator, (int)OrbitalEvaluator::Exact)) {
+        settings.sampler.evaluator = OrbitalEvaluator::Exact;
+        orbitalNeedsUpdate = true;
+    }
+    ImGui::SameLine();
+    if (ImGui::RadioButton("Tables", &evaluator, (int)OrbitalEvaluator::Table)) {
+        settings.sampler.evaluator = OrbitalEvaluator::Table;
+        orbitalNeedsUpdate = true;
+    }
+    ImGui::SameLine();
+    if (ImGui::RadioButton("Vector", &evaluator, (int)OrbitalEvaluator::Vector)) {
+        settings.sampler.evaluator = OrbitalEvaluator::Vector;
+        orbitalNeedsUpdate = true;
+    }
+    if (settings.sampler.evaluator == OrbitalEvaluator::Table) {
+        float tableError = (float)settings.sampler.tableError;
+        if (ImGui::SliderFloat("Table error", &tableError, 1e-6f, 1e-2f, "%.0e", ImGuiSliderFlags_Logarithmic)) {
+            settings.sampler.tableError = tableError;
+        }
+        if (ImGui::IsItemDeactivatedAfterEdit()) orbitalNeedsUpdate = true;
+    }
+    int accuracy = (int)settings.sampler.accuracy;
+    ImGui::Text("Math (%s x%d)", Simd::name(), VectorMath::getWidth());
+    for (MathAccuracy tier : {MathAccuracy::Precise, MathAccuracy::Fast, MathAccuracy::Visual}) {
+        ImGui::SameLine();
+        if (ImGui::RadioButton(VectorMath::name(tier), &accuracy, (int)tier)) {
+            settings.sampler.accuracy = tier;
+            orbitalNeedsUpdate = true;
+        }
+    }
+    // same seed, same cloud; the field takes any 64 bit value
+    ImGui::InputScalar("Seed", ImGuiDataType_U64, &settings.sampler.seed);
+    if (ImGui::IsItemDeactivatedAfterEdit()) orbitalNeedsUpdate = true;
+    ImGui::SameLine();
+    if (ImGui::Button("New")) {
+        std::random_device rd;
+        settings.sampler.seed = ((uint64_t)rd() << 32) | rd();
+        orbitalNeedsUpdate = true;
+    }
+    // blocks the frame for a moment, the timings are only meaningful on an idle machine anyway
+    if (ImGui::Button("Benchmark evaluators")) {
+        evaluatorBenchmark_ = OrbitalGenerator::benchmarkEvaluators(qn, 1 << 20, settings.sampler.tableError, settings.sampler.accuracy);
+        evaluatorBenchmarked_ = true;
+    }
+    if (evaluatorBenchmarked_) {
+        const OrbitalGenerator::EvaluatorBenchmark& b = evaluatorBenchmark_;
+        ImGui::Text("Kernel %.1f -> table %.1f, vector %.1f ms", b.exactKernelMs, b.tableKernelMs, b.vectorKernelMs);
+        ImGui::Text("Sampler %.1f -> table %.1f, vector %.1f ms", b.exactSampleMs, b.tableSampleMs, b.vectorSampleMs);
+        ImGui::Text("%d segments, error %.1e, built in %.2f ms", b.tableSegments, b.tableError, b.buildMs);
+    }
+
+    ImGui::Separator();
+    int hybrid = (int)settings.hybrid;
+    ImGui::Text("Hybrid");
+    for (HybridType type : {HybridType::None, HybridType::SP, HybridType::SP2, HybridType::SP3, HybridType::DSP3}) {
+        ImGui::SameLine();
+        if (ImGui::RadioButton(HybridOrbital::name(type), &hybrid, (int)type)) {
+            settings.hybrid = type;
+            orbitalNeedsUpdate = true;
+        }
+    }
+    if (settings.hybrid != HybridType::None && settings.comparison == ComparisonMode::Off && stats.hybridCount == 0) {
+        ImGui::TextDisabled("needs a larger n (dsp3 uses the d shell, n >= 3)");
+    }
+
+    ImGui::Separator();
+    int comparison = (int)settings.comparison;
+    ImGui::Text("Compare");
+    ImGui::SameLine();
+    if (ImGui::RadioButton("Off", &comparison, (int)ComparisonMode::Off)) settings.comparison = ComparisonMode::Off;
+    ImGui::SameLine();
+    if (ImGui::RadioButton("All m", &comparison, (int)ComparisonMode::Subshell)) settings.comparison = ComparisonMode::Subshell;
+    ImGui::SameLine();
+    if (ImGui::RadioButton("Whole shell", &comparison, (int)ComparisonMode::Shell)) settings.comparison = ComparisonMode::Shell;
+    if (settings.comparison != ComparisonMode::Off) {
+        int layout = (int)settings.comparisonLayout;
+        if (ImGui::RadioButton("Grid", &layout, (int)ComparisonLayout::Grid)) settings.comparisonLayout = ComparisonLayout::Grid;
+        ImGui::SameLine();
+        if (ImGui::RadioButton("Overlay", &layout, (int)ComparisonLayout::Overlay)) settings.comparisonLayout = ComparisonLayout::Overlay;
+        ImGui::Text("%d orbitals in one draw", stats.comparedOrbitals);
+    }
+
+    ImGui::Separator();
+    ImGui::Checkbox("Redraw only on change", &settings.idleRedraw);
+    std::string reasons;
+    for (unsigned bit = 1; bit <= RedrawScheduler::Window; bit <<= 1) {
+        if (!(stats.redrawReasons & bit)) continue;
+        if (!reasons.empty()) reasons += ", ";
+        reasons += RedrawScheduler::reasonName((RedrawScheduler::Reason)bit);
+    }
+    ImGui::Text("Frames drawn: %llu (%s)", stats.framesRendered, reasons.empty() ? "continuous" : reasons.c_str());
+
+    ImGui::Separator();
+    ImGui::Checkbox("Level of detail", &settings.lodEnabled);
+    if (settings.lodEnabled) {
+        ImGui::SliderFloat("Points per pixel", &settings.lodPointsPerPixel, 0.1f, 16.0f, "%.1f", ImGuiSliderFlags_Logarithmic);
+    }
+    ImGui::Checkbox("Adaptive quality", &settings.adaptiveQuality);
+    if (settings.adaptiveQuality) {
+        ImGui::SliderFloat("Frame budget (ms)", &settings.frameBudgetMs, 4.0f, 50.0f, "%.1f");
+        ImGui::Text("CPU %.2f ms  GPU %.2f ms", stats.cpuMs, stats.gpuMs);
+        ImGui::Text("Quality level %d / %d (points x%.2f, resolution x%.2f)", stats.qualityLevelCount - 1 - stats.qualityLevel,
+                    stats.qualityLevelCount - 1, stats.pointScale, stats.renderScale);
+    }
+    float drawnPercent = stats.totalPoints > 0 ? 100.0f * stats.drawnPoints / stats.totalPoints : 0.0f;
+    ImGui::Text("Drawing %d / %d points (%.0f%%), size %.1f px", stats.drawnPoints, stats.totalPoints, drawnPercent, stats.pointSize);
+    ImGui::Text("Internal resolution %d x %d", stats.renderWidth, stats.renderHeight);
+    ImGui::End();
+}
+
+void UIManager::drawAtomUI(AtomSettings& settings, const AtomCloud& atom, bool& atomNeedsUpdate) {
+    ImGui::Begin("Atom");
+    if (ImGui::Checkbox("Whole atom", &settings.enabled)) atomNeedsUpdate = true;
+
+    auto showConfiguration = [this](const std::vector<Subshell>& configuration) {
+        std::string text = ElectronConfiguration::format(configuration);
+        snprintf(atomText_, sizeof(atomText_), "%s", text.c_str());
+    };
+    if (atomText_[0] == '\0' && atomError_.empty()) showConfiguration(settings.configuration);
+
+    if (ImGui::SliderInt("Electrons", &settings.electrons, 1, ElectronConfiguration::MAX_ELECTRONS)) {
+        settings.configuration = ElectronConfiguration::aufbau(settings.electrons);
+        showConfiguration(settings.configuration);
+        atomError_.clear();
+        atomNeedsUpdate = true;
+    }
+    if (ImGui::InputText("Configuration", atomText_, sizeof(atomText_), ImGuiInputTextFlags_EnterReturnsTrue)) {
+        if (ElectronConfiguration::parse(atomText_, settings.configuration, atomError_)) {
+            settings.electrons = ElectronConfiguration::electronCount(settings.configuration);
+            atomNeedsUpdate = true;
+        }
+    }
+    if (!atomError_.empty()) ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "%s", atomError_.c_str());
+
+    ImGui::SliderInt("Points", &settings.pointBudget, 10000, 20000000, "%d", ImGuiSliderFlags_Logarithmic);
+    if (ImGui::IsItemDeactivatedAfterEdit()) atomNeedsUpdate = true;
+
+    if (settings.enabled) {
+        ImGui::Separator();
+        const std::vector<Subshell>& shown = atom.getConfiguration();
+        for (int i = 0; i < (int)shown.size(); ++i) {
+            const Subshell& s = shown[i];
+            glm::vec3 color = AtomCloud::subshellColor(s.n, s.l);
+            ImGui::TextColored(ImVec4(color.r, color.g, color.b, 1.0f), "%d%c%d", s.n, ElectronConfiguration::letter(s.l), s.electrons);
+            ImGui::SameLine(60.0f);
+            ImGui::Text("Zeff %5.2f  %d points", s.zeff, atom.getSubshellPoints(i));
+        }
+        ImGui::Text("Last update sampled %d sets in %.1f ms", atom.getLastSampledJobs(), atom.getLastUpdateMs());
+    }
+    ImGui::End();
+}
+
+// <cos^2 theta> of Y_lm
+static double meanCos2(const QuantumNumbers& qn) {
+    double l = qn.l, m = qn.m;
+    return (2.0 * l * (l + 1.0) - 2.0 * m * m - 1.0) / ((2.0 * l - 1.0) * (2.0 * l + 3.0));
+}
+
+struct ExpectationFunction {
+    const char* name;
+    double (*f)(double r, double theta, double phi);
+    double (*analytic)(const QuantumNumbers& qn); // nullptr when there is no closed form here
+    const char* formula;
+};
+
+static const ExpectationFunction EXPECTATION_FUNCTIONS[] = {
+    {"z^2", [](double r, double theta, double) { return std::pow(r * std::cos(theta), 2); },
+     [](const QuantumNumbers& qn) { return Expectation::analyticMeanR2(qn.n, qn.l) * meanCos2(qn); }, "<r^2> <cos^2>"},
+    {"x^2 + y^2", [](double r, double theta, double) { return std::pow(r * std::sin(theta), 2); },
+     [](const QuantumNumbers& qn) { return Expectation::analyticMeanR2(qn.n, qn.l) * (1.0 - meanCos2(qn)); }, "<r^2> (1 - <cos^2>)"},
+    {"|z|", [](double r, double theta, double) { return std::fabs(r * std::cos(theta)); }, nullptr, ""},
+    {"x^2", [](double r, double theta, double phi) { return std::pow(r * std::sin(theta) * std::cos(phi), 2); },
+     [](const QuantumNumbers& qn) { return Expectation::analyticMeanR2(qn.n, qn.l) * (1.0 - meanCos2(qn)) / 2.0; }, "<x^2 + y^2> / 2"},
+    {"e^-r", [](double r, double, double) { return std::exp(-r); }, nullptr, ""},
+};
+
+void UIManager::drawExpectationUI(const QuantumNumbers& qn) {
+    ImGui::Begin("Expectation values");
+    std::shared_ptr<const StateExpectation> values = Expectation::get(qn);
+    const int n = qn.n, l = qn.l;
+    ImGui::Text("n %d, l %d, m %d in Bohr radii for Z = 1", n, l, qn.m);
+
+    auto row = [](const char* name, double quadrature, const char* formula, double analytic) {
+        ImGui::TableNextRow();
+        ImGui::TableNextColumn();
+        ImGui::TextUnformatted(name);
+        ImGui::TableNextColumn();
+        ImGui::Text("%.10g", quadrature);
+        ImGui::TableNextColumn();
+        ImGui::TextUnformatted(formula);
+        ImGui::TableNextColumn();
+        if (formula[0] != '\0') ImGui::Text("%.10g", analytic);
+    };
+    if (ImGui::BeginTable("expectation", 4, ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingFixedFit)) {
+        ImGui::TableSetupColumn("");
+        ImGui::TableSetupColumn("Quadrature");
+        ImGui::TableSetupColumn("Formula");
+        ImGui::TableSetupColumn("Analytic");
+        ImGui::TableHeadersRow();
+        row("norm", values->norm, "1", 1.0);
+        row("<r>", values->meanR, "(3n^2 - l(l+1)) / 2", Expectation::analyticMeanR(n, l));
+        row("<r^2>", values->meanR2, "n^2 (5n^2 + 1 - 3l(l+1)) / 2", Expectation::analyticMeanR2(n, l));
+        row("<1/r>", values->meanInvR, "1 / n^2", Expectation::analyticMeanInvR(n));
+
+        // the integrand is opaque, so the full 3D quadrature runs once per function and state
+        const ExpectationFunction& custom = EXPECTATION_FUNCTIONS[expectationFunction_];
+        int key = ((expectationFunction_ * 64 + n) * 64 + l) * 128 + qn.m + 64;
+        if (key != expectationKey_) {
+            expectationValue_ = Expectation::evaluate(qn, custom.f);
+            expectationKey_ = key;
+        }
+        std::string name = std::string("<") + custom.name + ">";
+        row(name.c_str(), expectationValue_, custom.formula, custom.analytic ? custom.analytic(qn) : 0.0);
+        ImGui::EndTable();
+    }
+    if (ImGui::BeginCombo("f(r, theta, phi)", EXPECTATION_FUNCTIONS[expectationFunction_].name)) {
+        for (int i = 0; i < (int)(sizeof(EXPECTATION_FUNCTIONS) / sizeof(EXPECTATION_FUNCTIONS[0])); ++i) {
+            if (ImGui::Selectable(EXPECTATION_FUNCTIONS[i].name, i == expectationFunction_)) expectationFunction_ = i;
+        }
+        ImGui::EndCombo();
+    }
+    ImGui::Text("Sampling radius %.2f (tail %.0e), %.2f ms", values->samplingRadius, Expectation::SAMPLING_TAIL, values->ms);
+    ImGui::End();
+}
+
+void UIManager::drawTransitionUI() {
+    ImGui::Begin("Transitions");
+    // a 40 shell table takes a noticeable moment, rebuild once the slider is let go
+    ImGui::SliderInt("n max", &transitionMaxN_, 2, 40);
+    if (!ImGui::IsItemActive()) transitions_.build(transitionMaxN_);
+    ImGui::Text("%d lines up to n = %d, table built in %.2f ms", (int)transitions_.getLines().size(), transitions_.getMaxN(), transitions_.getBuildMs());
+    if (ImGui::RadioButton("Einstein A", transitionRates_)) transitionRates_ = true;
+    ImGui::SameLine();
+    if (ImGui::RadioButton("Oscillator strength", !transitionRates_)) transitionRates_ = false;
+    std::string series = transitionSeries_ == 0 ? "All" : std::string(TransitionTable::seriesName(transitionSeries_));
+    if (series.empty()) series = "n_lower = " + std::to_string(transitionSeries_);
+    if (ImGui::BeginCombo("Series", series.c_str())) {
+        if (ImGui::Selectable("All", transitionSeries_ == 0)) transitionSeries_ = 0;
+        for (int n = 1; n <= std::min(transitions_.getMaxN() - 1, 6); ++n) {
+            if (ImGui::Selectable(TransitionTable::seriesName(n), transitionSeries_ == n)) transitionSeries_ = n;
+        }
+        ImGui::EndCombo();
+    }
+    if (transitionSeries_ >= transitions_.getMaxN()) transitionSeries_ = 0;
+
+    std::vector<const SpectralLine*> shown;
+    for (const SpectralLine& line : transitions_.getLines()) {
+        if (transitionSeries_ == 0 || line.nLower == transitionSeries_) shown.push_back(&line);
+    }
+    auto strength = [this](const SpectralLine& line) { return transitionRates_ ? line.einsteinA : line.oscillatorStrength; };
+    if (shown.empty()) {
+        ImGui::End();
+        return;
+    }
+
+    // log wavelength across, log strength up: the lines span several decades of both
+    double minL = INFINITY, maxL = 0.0, minS = INFINITY, maxS = 0.0;
+    for (const SpectralLine* line : shown) {
+        minL = std::min(minL, line->wavelengthNm);
+        maxL = std::max(maxL, line->wavelengthNm);
+        minS = std::min(minS, strength(*line));
+        maxS = std::max(maxS, strength(*line));
+    }
+    const double logMinL = std::log10(minL) - 0.05, logMaxL = std::log10(maxL) + 0.05;
+    const double logMinS = std::log10(minS) - 0.2, logMaxS = std::log10(maxS);
+
+    ImVec2 origin = ImGui::GetCursorScreenPos();
+    ImVec2 size(std::max(ImGui::GetContentRegionAvail().x, 100.0f), 180.0f);
+    ImGui::InvisibleButton("spectrum", size);
+    ImDrawList* draw = ImGui::GetWindowDrawList();
+    const float bottom = origin.y + size.y - 14.0f;
+    auto xOf = [&](double nm) { return origin.x + (float)((std::log10(nm) - logMinL) / (logMaxL - logMinL)) * size.x; };
+    auto yOf = [&](double value) { return bottom - (float)((std::log10(value) - logMinS) / (logMaxS - logMinS)) * (bottom - origin.y); };
+    draw->AddRectFilled(origin, ImVec2(origin.x + size.x, bottom), IM_COL32(20, 20, 24, 255));
+    float visibleLo = std::max(xOf(380.0), origin.x), visibleHi = std::min(xOf(750.0), origin.x + size.x);
+    if (visibleLo < visibleHi) draw->AddRectFilled(ImVec2(visibleLo, origin.y), ImVec2(visibleHi, bottom), IM_COL32(60, 60, 40, 255));
+    for (int decade = (int)std::ceil(logMinL); decade <= (int)std::floor(logMaxL); ++decade) {
+        float x = xOf(std::pow(10.0, decade));
+        draw->AddLine(ImVec2(x, bottom), ImVec2(x, bottom + 4.0f), IM_COL32(160, 160, 160, 255));
+        char label[32];
+        snprintf(label, sizeof(label), "%.0f nm", std::pow(10.0, decade));
+        draw->AddText(ImVec2(x + 2.0f, bottom), IM_COL32(160, 160, 160, 255), label);
+    }
+
+    const SpectralLine* hovered = nullptr;
+    float hoveredDistance = 4.0f;
+    float mouseX = ImGui::GetIO().MousePos.x;
+    for (const SpectralLine* line : shown) {
+        float x = xOf(line->wavelengthNm);
+        ImU32 color = ImColor::HSV(std::fmod((line->nLower - 1) * 0.17f, 1.0f), 0.7f, 1.0f);
+        draw->AddLine(ImVec2(x, bottom), ImVec2(x, yOf(strength(*line))), color);
+        if (ImGui::IsItemHovered() && std::fabs(x - mouseX) < hoveredDistance) {
+            hoveredDistance = std::fabs(x - mouseX);
+            hovered = line;
+        }
+    }
+    if (hovered) {
+        ImGui::BeginTooltip();
+        ImGui::Text("%d -> %d %s", hovered->nUpper, hovered->nLower, TransitionTable::seriesName(hovered->nLower));
+        ImGui::Text("%.2f nm", hovered->wavelengthNm);
+        ImGui::Text("A %.3e /s  f %.4g  S %.4g", hovered->einsteinA, hovered->oscillatorStrength, hovered->lineStrength);
+        ImGui::EndTooltip();
+    }
+
+    if (ImGui::BeginTable("lines", 5, ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY | ImGuiTableFlags_SizingFixedFit, ImVec2(0.0f, 160.0f))) {
+        ImGui::TableSetupColumn("Line");
+        ImGui::TableSetupColumn("nm");
+        ImGui::TableSetupColumn("A (1/s)");
+        ImGui::TableSetupColumn("f");
+        ImGui::TableSetupColumn("S (a.u.)");
+        ImGui::TableHeadersRow();
+        for (const SpectralLine* line : shown) {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::Text("%d -> %d", line->nUpper, line->nLower);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.2f", line->wavelengthNm);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3e", line->einsteinA);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.4g", line->oscillatorStrength);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.4g", line->lineStrength);
+        }
+        ImGui::EndTable();
+    }
+    ImGui::End();
+}
+
+void UIManager::drawProfilerUI(Profiler& profiler) {
+    ImGui::Begin("Profiler");
+    bool enabled = profiler.isEnabled();
+    if (ImGui::Checkbox("Enabled", &enabled)) profiler.setEnabled(enabled);
+    ImGui::SameLine();
+    ImGui::Checkbox("GPU graphs", &profilerShowGpu_);
+    ImGui::SameLine();
+    if (ImGui::Button("Export CSV")) {
+        profilerExportPath_ = profiler.exportCsv();
+        if (profilerExportPath_.empty()) profilerExportPath_ = "export failed";
+    }
+    if (!profilerExportPath_.empty()) ImGui::TextDisabled("%s", profilerExportPath_.c_str());
+#ifdef HYDROGEN_TRACING
+    if (ImGui::Button("Dump trace")) {
+        traceDumpPath_ = Trace::dump();
+        if (traceDumpPath_.empty()) traceDumpPath_ = "trace dump failed";
+    }
+    if (!traceDumpPath_.empty()) ImGui::TextDisabled("%s", traceDumpPath_.c_str());
+#endif
+
+    float history[Profiler::HISTORY];
+    Profiler::Percentiles frame = profiler.getPercentiles(profiler.getFrameMs());
+    profiler.getHistory(profiler.getFrameMs(), history);
+    ImGui::Text("Frame CPU  p50 %.2f  p95 %.2f  p99 %.2f ms", frame.p50, frame.p95, frame.p99);
+    ImGui::PlotLines("##frame", history, Profiler::HISTORY, 0, nullptr, 0.0f, frame.p99 * 1.2f, ImVec2(-1.0f, 50.0f));
+
+    if (ImGui::BeginTable("stages", 7, ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingFixedFit)) {
+        ImGui::TableSetupColumn("Stage");
+        ImGui::TableSetupColumn("CPU p50");
+        ImGui::TableSetupColumn("CPU p95");
+        ImGui::TableSetupColumn("CPU p99");
+        ImGui::TableSetupColumn("GPU p50");
+        ImGui::TableSetupColumn("GPU p95");
+        ImGui::TableSetupColumn("GPU p99");
+        ImGui::TableHeadersRow();
+        for (const Profiler::Stage& stage : profiler.getStages()) {
+            Profiler::Percentiles cpu = profiler.getPercentiles(stage.cpuMs);
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(stage.name.c_str());
+            ImGui::TableNextColumn();
+            ImGui::Text("%.2f", cpu.p50);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.2f", cpu.p95);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.2f", cpu.p99);
+            if (stage.gpu) {
+                Profiler::Percentiles gpu = profiler.getPercentiles(stage.gpuMs);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.2f", gpu.p50);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.2f", gpu.p95);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.2f", gpu.p99);
+            }
+        }
+        ImGui::EndTable();
+    }
+
+    // one graph per stage, scaled to its own p99 so short stages stay readable
+    for (const Profiler::Stage& stage : profiler.getStages()) {
+        const float* ring = profilerShowGpu_ && stage.gpu ? stage.gpuMs : stage.cpuMs;
+        Profiler::Percentiles percentiles = profiler.getPercentiles(ring);
+        profiler.getHistory(ring, history);
+        ImGui::PlotLines(stage.name.c_str(), history, Profiler::HISTORY, 0, nullptr, 0.0f,
+                         std::max(percentiles.p99 * 1.2f, 0.01f), ImVec2(0.0f, 30.0f));
+    }
+    ImGui::End();
+}
+
+void UIManager::drawDebugUI() {
+    ImGui::Begin("GL Debug");
+    int mode = (int)getGLDebugMode();
+    for (GLDebugMode option : {GLDebugMode::Off, GLDebugMode::Aggregated, GLDebugMode::Synchronous}) {
+        if (option != GLDebugMode::Off) ImGui::SameLine();
+        if (ImGui::RadioButton(getGLDebugModeName(option), &mode, (int)option)) setGLDebugMode(option);
+    }
+    if (getGLDebugMode() == GLDebugMode::Off) ImGui::TextDisabled("Switching on needs a debug context on some drivers (HYDROGEN_GL_DEBUG)");
+
+    GLDebugCounter counters[256];
+    int count = getGLDebugCounters(counters, 256);
+    std::sort(counters, counters + count, [](const GLDebugCounter& a, const GLDebugCounter& b) { return a.count > b.count; });
+
+    if (ImGui::Button("Reset counts")) resetGLDebugCounters();
+    ImGui::SameLine();
+    ImGui::Text("%d ids, %u dropped", count, getGLDebugDroppedMessages());
+
+    if (ImGui::BeginTable("messages", 3, ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY | ImGuiTableFlags_Resizable)) {
+        ImGui::TableSetupColumn("Id", ImGuiTableColumnFlags_WidthFixed);
+        ImGui::TableSetupColumn("Count", ImGuiTableColumnFlags_WidthFixed);
+        ImGui::TableSetupColumn("Message");
+        ImGui::TableHeadersRow();
+        for (int i = 0; i < count; ++i) {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::Text("%u", counters[i].id);
+            ImGui::TableNextColumn();
+            ImGui::Text("%u", counters[i].count);
+            ImGui::TableNextColumn();
+            ImGui::TextWrapped("%s", counters[i].message);
+        }
+        ImGui::EndTable();
+    }
     ImGui::End();
 }
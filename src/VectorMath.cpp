@@ -0,0 +1,226 @@
+#include "VectorMath.h"
+#include "Simd.h"
+
+using Simd::Float;
+using Simd::Int;
+
+// Cephes style kernels: reduce the argument, evaluate a short polynomial, undo the reduction.
+// Lower tiers only drop polynomial terms. Products and sums are written out one operation at
+// a time (no fused multiply-add), so every width rounds identically.
+
+static inline Float polynomial(Float x, const float* c, int degree) {
+    Float y = Simd::set(c[0]);
+    for (int i = 1; i <= degree; ++i) y = y * x + Simd::set(c[i]);
+    return y;
+}
+
+template <MathAccuracy A>
+static inline Float expKernel(Float x) {
+    x = Simd::min(Simd::max(x, Simd::set(-87.0f)), Simd::set(88.0f));
+
+    // x = n ln2 + r with |r| <= ln2 / 2, ln2 split in two so n ln2 is exact
+    Int n = Simd::roundToInt(x * Simd::set(1.44269504088896341f));
+    Float fn = Simd::toFloat(n);
+    Float r = x - fn * Simd::set(0.693359375f);
+    r = r + fn * Simd::set(2.12194440e-4f);
+
+    Float p;
+    if (A == MathAccuracy::Precise) {
+        static const float c[] = {1.9875691500e-4f, 1.3981999507e-3f, 8.3334519073e-3f, 4.1665795894e-2f, 1.6666665459e-1f, 5.0000001201e-1f};
+        p = polynomial(r, c, 5) * r * r + r + Simd::set(1.0f);
+    } else if (A == MathAccuracy::Fast) {
+        static const float c[] = {1.0f / 24.0f, 1.0f / 6.0f, 0.5f, 1.0f, 1.0f};
+        p = polynomial(r, c, 4);
+    } else {
+        static const float c[] = {0.5f, 1.0f, 1.0f};
+        p = polynomial(r, c, 2);
+    }
+
+    // 2^n straight into the exponent bits
+    Float scale = Simd::asFloat((n + Simd::set(127)) << 23);
+    return p * scale;
+}
+
+template <MathAccuracy A>
+static inline Float logKernel(Float x) {
+    // x = m 2^e with m in [sqrt(1/2), sqrt(2))
+    Int bits = Simd::asInt(x);
+    Int e = Simd::shiftRight(bits, 23) - Simd::set(127);
+    Float m = Simd::asFloat((bits & Simd::set(0x007fffff)) | Simd::set(0x3f800000));
+    Float big = Simd::set(1.41421356f) < m;
+    m = Simd::select(big, m * Simd::set(0.5f), m);
+    Float fe = Simd::toFloat(e) + (big & Simd::set(1.0f));
+    Float f = m - Simd::set(1.0f);
+
+    if (A == MathAccuracy::Precise) {
+        static const float c[] = {7.0376836292e-2f, -1.1514610310e-1f, 1.1676998740e-1f, -1.2420140846e-1f, 1.4249322787e-1f,
+                                  -1.6668057665e-1f, 2.0000714765e-1f, -2.4999993993e-1f, 3.3333331174e-1f};
+        Float z = f * f;
+        Float y = polynomial(f, c, 8) * f * z;
+        y = y - fe * Simd::set(2.12194440e-4f);
+        y = y - z * Simd::set(0.5f);
+        return f + y + fe * Simd::set(0.693359375f);
+    }
+
+    // log(1 + f) = 2 atanh(s) with s = f / (2 + f), |s| <= 0.172
+    Float s = f / (f + Simd::set(2.0f));
+    Float s2 = s * s;
+    Float series;
+    if (A == MathAccuracy::Fast) {
+        static const float c[] = {2.0f / 5.0f, 2.0f / 3.0f, 2.0f};
+        series = polynomial(s2, c, 2);
+    } else {
+        static const float c[] = {2.0f / 3.0f, 2.0f};
+        series = polynomial(s2, c, 1);
+    }
+    return series * s + fe * Simd::set(0.69314718056f);
+}
+
+// x = j pi/2 + r with |r| <= pi/4, pi/2 in three parts (Cody and Waite)
+static inline Float reduceQuadrant(Float x, Int& j) {
+    j = Simd::roundToInt(x * Simd::set(0.63661977236758134f));
+    Float fj = Simd::toFloat(j);
+    Float r = x - fj * Simd::set(1.5703125f);
+    r = r - fj * Simd::set(4.837512969970703125e-4f);
+    r = r - fj * Simd::set(7.549789948768648e-8f);
+    return r;
+}
+
+template <MathAccuracy A>
+static inline void sincosKernel(Float r, Float& s, Float& c) {
+    Float r2 = r * r;
+    if (A == MathAccuracy::Precise) {
+        static const float sc[] = {-1.9515295891e-4f, 8.3321608736e-3f, -1.6666654611e-1f};
+        static const float cc[] = {2.443315711809948e-5f, -1.388731625493765e-3f, 4.166664568298827e-2f};
+        s = polynomial(r2, sc, 2) * r2 * r + r;
+        c = polynomial(r2, cc, 2) * r2 * r2 - r2 * Simd::set(0.5f) + Simd::set(1.0f);
+    } else if (A == MathAccuracy::Fast) {
+        static const float sc[] = {1.0f / 120.0f, -1.0f / 6.0f, 1.0f};
+        static const float cc[] = {-1.0f / 720.0f, 1.0f / 24.0f, -0.5f, 1.0f};
+        s = polynomial(r2, sc, 2) * r;
+        c = polynomial(r2, cc, 3);
+    } else {
+        static const float sc[] = {-1.0f / 6.0f, 1.0f};
+        static const float cc[] = {1.0f / 24.0f, -0.5f, 1.0f};
+        s = polynomial(r2, sc, 1) * r;
+        c = polynomial(r2, cc, 2);
+    }
+}
+
+// quadrant j: sin x = sin r, cos r, -sin r, -cos r and cos x = cos r, -sin r, -cos r, sin r
+static inline void applyQuadrant(Int j, Float& s, Float& c) {
+    Float swap = Simd::asFloat((j & Simd::set(1)) == Simd::set(1));
+    Float sinSign = Simd::asFloat((j & Simd::set(2)) << 30);
+    Float cosSign = Simd::asFloat(((j + Simd::set(1)) & Simd::set(2)) << 30);
+    Float sr = s;
+    s = Simd::select(swap, c, sr) ^ sinSign;
+    c = Simd::select(swap, sr, c) ^ cosSign;
+}
+
+// Runs kernel over whole vectors, the tail goes through a padded copy
+template <typename Kernel>
+static void forEach(const float* x, float* y, size_t count, Kernel kernel) {
+    size_t i = 0;
+    for (; i + Simd::WIDTH <= count; i += Simd::WIDTH) {
+        Simd::store(y + i, kernel(Simd::load(x + i)));
+    }
+    if (i < count) {
+        float in[Simd::WIDTH] = {}, out[Simd::WIDTH];
+        for (size_t k = i; k < count; ++k) in[k - i] = x[k];
+        Simd::store(out, kernel(Simd::load(in)));
+        for (size_t k = i; k < count; ++k) y[k] = out[k - i];
+    }
+}
+
+template <MathAccuracy A>
+static void sincosArray(const float* x, float* s, float* c, size_t count) {
+    auto kernel = [](Float v, Float& sv, Float& cv) {
+        Int j;
+        Float r = reduceQuadrant(v, j);
+        sincosKernel<A>(r, sv, cv);
+        applyQuadrant(j, sv, cv);
+    };
+    size_t i = 0;
+    for (; i + Simd::WIDTH <= count; i += Simd::WIDTH) {
+        Float sv, cv;
+        kernel(Simd::load(x + i), sv, cv);
+        Simd::store(s + i, sv);
+        Simd::store(c + i, cv);
+    }
+    if (i < count) {
+        float in[Simd::WIDTH] = {}, sOut[Simd::WIDTH], cOut[Simd::WIDTH];
+        for (size_t k = i; k < count; ++k) in[k - i] = x[k];
+        Float sv, cv;
+        kernel(Simd::load(in), sv, cv);
+        Simd::store(sOut, sv);
+        Simd::store(cOut, cv);
+        for (size_t k = i; k < count; ++k) {
+            s[k] = sOut[k - i];
+            c[k] = cOut[k - i];
+        }
+    }
+}
+
+// Accuracy is a template argument so the tier is chosen once per call, not per element
+#define DISPATCH(accuracy, call)                                          \
+    switch (accuracy) {                                                   \
+    case MathAccuracy::Precise: { const MathAccuracy A = MathAccuracy::Precise; call; break; } \
+    case MathAccuracy::Fast: { const MathAccuracy A = MathAccuracy::Fast; call; break; }       \
+    default: { const MathAccuracy A = MathAccuracy::Visual; call; break; }                     \
+    }
+
+namespace VectorMath {
+
+const char* name(MathAccuracy accuracy) {
+    switch (accuracy) {
+    case MathAccuracy::Precise: return "precise";
+    case MathAccuracy::Fast: return "fast";
+    default: return "visual";
+    }
+}
+
+double errorBound(MathAccuracy accuracy) {
+    switch (accuracy) {
+    case MathAccuracy::Precise: return 2.4e-7;
+    case MathAccuracy::Fast: return 1e-4;
+    default: return 1e-2;
+    }
+}
+
+int getWidth() {
+    return Simd::WIDTH;
+}
+
+void exp(const float* x, float* y, size_t count, MathAccuracy accuracy) {
+    DISPATCH(accuracy, forEach(x, y, count, [](Float v) { return expKernel<A>(v); }));
+}
+
+void log(const float* x, float* y, size_t count, MathAccuracy accuracy) {
+    DISPATCH(accuracy, forEach(x, y, count, [](Float v) { return logKernel<A>(v); }));
+}
+
+void sin(const float* x, float* y, size_t count, MathAccuracy accuracy) {
+    DISPATCH(accuracy, forEach(x, y, count, [](Float v) {
+        Int j;
+        Float s, c;
+        sincosKernel<A>(reduceQuadrant(v, j), s, c);
+        applyQuadrant(j, s, c);
+        return s;
+    }));
+}
+
+void cos(const float* x, float* y, size_t count, MathAccuracy accuracy) {
+    DISPATCH(accuracy, forEach(x, y, count, [](Float v) {
+        Int j;
+        Float s, c;
+        sincosKernel<A>(reduceQuadrant(v, j), s, c);
+        applyQuadrant(j, s, c);
+        return c;
+    }));
+}
+
+void sincos(const float* x, float* s, float* c, size_t count, MathAccuracy accuracy) {
+    DISPATCH(accuracy, sincosArray<A>(x, s, c, count));
+}
+
+} // namespace VectorMath
@@ -1,6 +1,14 @@
 #include <demoShaderLoader.h>
+#include "Trace.h"
 #include <iostream>
 #include <fstream>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <sstream>
+#include <thread>
 
 //path is used for error reporting
 GLint createShaderFromData(const char *data, GLenum shaderType, const char *path = 0)
@@ -48,10 +56,9 @@ GLint createShaderFromData(const char *data, GLenum shaderType, const char *path
 }
 
 
-GLint createShaderFromFile(const char *name, GLenum shaderType)
+bool readShaderFile(const char *name, std::string &str)
 {
 	std::ifstream f(name);
-	std::string str;
 
 	if (!f.is_open())
 	{
@@ -72,7 +79,18 @@ GLint createShaderFromFile(const char *name, GLenum shaderType)
 	str.assign((std::istreambuf_iterator<char>(f)),
 		std::istreambuf_iterator<char>());
 
-	
+	return true;
+}
+
+GLint createShaderFromFile(const char *name, GLenum shaderType)
+{
+	std::string str;
+
+	if (!readShaderFile(name, str))
+	{
+		return 0;
+	}
+
 	auto rez = createShaderFromData(str.c_str(), shaderType, name);
 
 	return rez;
@@ -123,6 +141,8 @@ bool Shader::loadShaderProgramFromData(const char *vertexShaderData, const char
 
 	glValidateProgram(id);
 
+	reflect();
+
 	return true;
 }
 
@@ -174,17 +194,24 @@ bool Shader::loadShaderProgramFromData(const char *vertexShaderData, const char
 
 	glValidateProgram(id);
 
+	reflect();
+
 	return true;
 }
 
 bool Shader::loadShaderProgramFromFile(const char *vertexShader, const char *fragmentShader)
 {
+	ShaderProgramSource source = {this, vertexShader, fragmentShader};
+	return loadShaderProgramsFromFiles(&source, 1);
+}
 
+bool Shader::loadShaderProgramFromFile(const char *vertexShader, const char *geometryShader, const char *fragmentShader)
+{
 	auto vertexId = createShaderFromFile(vertexShader, GL_VERTEX_SHADER);
+	auto geometryId = createShaderFromFile(geometryShader, GL_GEOMETRY_SHADER);
 	auto fragmentId = createShaderFromFile(fragmentShader, GL_FRAGMENT_SHADER);
 
-
-	if (vertexId == 0 || fragmentId == 0)
+	if (vertexId == 0 || fragmentId == 0 || geometryId == 0)
 	{
 		return 0;
 	}
@@ -192,11 +219,13 @@ bool Shader::loadShaderProgramFromFile(const char *vertexShader, const char *fra
 	id = glCreateProgram();
 
 	glAttachShader(id, vertexId);
+	glAttachShader(id, geometryId);
 	glAttachShader(id, fragmentId);
 
 	glLinkProgram(id);
 
 	glDeleteShader(vertexId);
+	glDeleteShader(geometryId);
 	glDeleteShader(fragmentId);
 
 	GLint info = 0;
@@ -224,82 +253,326 @@ bool Shader::loadShaderProgramFromFile(const char *vertexShader, const char *fra
 
 	glValidateProgram(id);
 
+	reflect();
+
 	return true;
 }
 
-bool Shader::loadShaderProgramFromFile(const char *vertexShader, const char *geometryShader, const char *fragmentShader)
+void Shader::bind()
 {
-	auto vertexId = createShaderFromFile(vertexShader, GL_VERTEX_SHADER);
-	auto geometryId = createShaderFromFile(geometryShader, GL_GEOMETRY_SHADER);
-	auto fragmentId = createShaderFromFile(fragmentShader, GL_FRAGMENT_SHADER);
+	glUseProgram(id);
+}
 
-	if (vertexId == 0 || fragmentId == 0 || geometryId == 0)
+void Shader::clear()
+{
+	glDeleteProgram(id);
+	id = 0;
+	uniforms.clear();
+}
+
+//caches every active uniform location once after linking and hooks the program up to the shared per-frame block
+void Shader::reflect()
+{
+	uniforms.clear();
+
+	GLint count = 0;
+	GLint maxLength = 0;
+	glGetProgramiv(id, GL_ACTIVE_UNIFORMS, &count);
+	glGetProgramiv(id, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+
+	std::vector<char> name(maxLength + 1);
+	for (GLint i = 0; i < count; i++)
 	{
-		return 0;
+		GLsizei length = 0;
+		GLint size = 0;
+		GLenum type = 0;
+		glGetActiveUniform(id, (GLuint)i, (GLsizei)name.size(), &length, &size, &type, name.data());
+
+		//members of uniform blocks have no location
+		GLint location = glGetUniformLocation(id, name.data());
+		if (location == -1) { continue; }
+
+		std::string uniformName(name.data(), length);
+		if (uniformName.size() > 3 && uniformName.compare(uniformName.size() - 3, 3, "[0]") == 0)
+		{
+			uniformName.resize(uniformName.size() - 3);
+		}
+		uniforms[uniformName] = location;
 	}
 
-	id = glCreateProgram();
+	GLuint cameraBlock = glGetUniformBlockIndex(id, "Camera");
+	if (cameraBlock != GL_INVALID_INDEX)
+	{
+		glUniformBlockBinding(id, cameraBlock, CAMERA_BLOCK_BINDING);
+	}
+}
 
-	glAttachShader(id, vertexId);
-	glAttachShader(id, geometryId);
-	glAttachShader(id, fragmentId);
+GLint Shader::getUniform(const char *name)
+{
+	auto it = uniforms.find(name);
+	if (it == uniforms.end())
+	{
+		std::cout << "uniform error " + std::string(name);
+		return -1;
+	}
+	return it->second;
+}
 
-	glLinkProgram(id);
+GLint getUniform(GLuint shaderId, const char *name)
+{
+	GLint uniform = glGetUniformLocation(shaderId, name);
+	if (uniform == -1)
+	{
+		std::cout << "uniform error " + std::string(name);
+	}
+	return uniform;
+}
 
-	glDeleteShader(vertexId);
-	glDeleteShader(geometryId);
-	glDeleteShader(fragmentId);
+void UniformBuffer::create(GLsizeiptr size, GLuint binding)
+{
+	this->size = size;
+	glGenBuffers(1, &id);
+	glBindBuffer(GL_UNIFORM_BUFFER, id);
+	glBufferData(GL_UNIFORM_BUFFER, size, nullptr, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	glBindBufferBase(GL_UNIFORM_BUFFER, binding, id);
+}
 
-	GLint info = 0;
-	glGetProgramiv(id, GL_LINK_STATUS, &info);
+void UniformBuffer::update(const void *data)
+{
+	glBindBuffer(GL_UNIFORM_BUFFER, id);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, size, data);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
 
-	if (info != GL_TRUE)
+void UniformBuffer::clear()
+{
+	glDeleteBuffers(1, &id);
+	id = 0;
+	size = 0;
+}
+
+static std::string shaderCacheDirectory = "shader_cache";
+
+void setShaderCacheDirectory(const char *path)
+{
+	shaderCacheDirectory = path ? path : "";
+}
+
+//FNV-1a, only used to name cache entries
+static uint64_t hashString(uint64_t hash, const std::string &str)
+{
+	for (unsigned char c : str)
 	{
-		char *message = 0;
-		int   l = 0;
+		hash ^= c;
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
 
-		glGetProgramiv(id, GL_INFO_LOG_LENGTH, &l);
+static bool programBinarySupported()
+{
+	if (!GLAD_GL_VERSION_4_1 && !GLAD_GL_ARB_get_program_binary) { return false; }
 
-		message = new char[l];
+	GLint formats = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+	return formats > 0;
+}
 
-		glGetProgramInfoLog(id, l, &l, message);
+//the key covers the sources and the driver, a driver update simply misses the cache
+static std::string programCachePath(const std::string &vertexSource, const std::string &fragmentSource)
+{
+	uint64_t hash = 14695981039346656037ull;
+	hash = hashString(hash, vertexSource);
+	hash = hashString(hash, "\x01");
+	hash = hashString(hash, fragmentSource);
+	hash = hashString(hash, (const char *)glGetString(GL_VENDOR));
+	hash = hashString(hash, (const char *)glGetString(GL_RENDERER));
+	hash = hashString(hash, (const char *)glGetString(GL_VERSION));
+
+	char name[32];
+	snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)hash);
+	return (std::filesystem::path(shaderCacheDirectory) / name).string();
+}
 
-		std::cout << std::string("Link error: ") + message << "\n";
+static GLuint loadProgramBinary(const std::string &path)
+{
+	std::ifstream f(path, std::ios::binary);
+	if (!f.is_open()) { return 0; }
 
-		delete[] message;
+	GLenum format = 0;
+	if (!f.read((char *)&format, sizeof(format))) { return 0; }
+	std::vector<char> binary((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+	if (binary.empty()) { return 0; }
 
+	GLuint id = glCreateProgram();
+	glProgramBinary(id, format, binary.data(), (GLsizei)binary.size());
+
+	GLint info = 0;
+	glGetProgramiv(id, GL_LINK_STATUS, &info);
+	if (info != GL_TRUE)
+	{
+		//the driver rejected it (different build, different GPU), recompile from source
 		glDeleteProgram(id);
-		id = 0;
 		return 0;
 	}
 
-	glValidateProgram(id);
-
-	return true;
+	return id;
 }
 
-void Shader::bind()
+static void saveProgramBinary(GLuint id, const std::string &path)
 {
-	glUseProgram(id);
-}
+	GLint length = 0;
+	glGetProgramiv(id, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0) { return; }
 
-void Shader::clear()
-{
-	glDeleteProgram(id);
-	id = 0;
+	std::vector<char> binary(length);
+	GLenum format = 0;
+	glGetProgramBinary(id, length, &length, &format, binary.data());
+
+	std::error_code ec;
+	std::filesystem::create_directories(shaderCacheDirectory, ec);
+
+	//several contexts may cache the same program at once, only complete files get the final name
+	std::ostringstream tmpPath;
+	tmpPath << path << "." << std::this_thread::get_id() << ".tmp";
+	{
+		std::ofstream f(tmpPath.str(), std::ios::binary);
+		if (!f.is_open()) { return; }
+		f.write((const char *)&format, sizeof(format));
+		f.write(binary.data(), length);
+		if (!f) { return; }
+	}
+	std::filesystem::rename(tmpPath.str(), path, ec);
+	if (ec) { std::filesystem::remove(tmpPath.str(), ec); }
 }
 
-GLint Shader::getUniform(const char *name)
+static void printShaderLog(GLuint shaderId, const char *path)
 {
-	return ::getUniform(this->id, name);
+	GLint rezult = 0;
+	glGetShaderiv(shaderId, GL_COMPILE_STATUS, &rezult);
+	if (rezult) { return; }
+
+	int l = 0;
+	glGetShaderiv(shaderId, GL_INFO_LOG_LENGTH, &l);
+	if (l)
+	{
+		std::vector<char> message(l);
+		glGetShaderInfoLog(shaderId, l, &l, message.data());
+		std::cout << "error compiling shader: " << path << "\n" << message.data() << "\n";
+	}
+	else
+	{
+		std::cout << path << " unknown error while compiling shader :(\n";
+	}
 }
 
-GLint getUniform(GLuint shaderId, const char *name)
+bool loadShaderProgramsFromFiles(ShaderProgramSource *programs, int count)
 {
-	GLint uniform = glGetUniformLocation(shaderId, name);
-	if (uniform == -1)
+	TRACE_SCOPE("loadShaderPrograms");
+
+	struct Pending
 	{
-		std::cout << "uniform error " + std::string(name);
+		ShaderProgramSource *source;
+		std::string cachePath;
+		GLuint vertexId;
+		GLuint fragmentId;
+	};
+
+	bool useCache = !shaderCacheDirectory.empty() && programBinarySupported();
+
+	//let the driver compile on its own threads, nothing below asks for a status until every
+	//program has been submitted, so the first link status query is the only wait
+	if (GLAD_GL_KHR_parallel_shader_compile) { glMaxShaderCompilerThreadsKHR(0xFFFFFFFF); }
+	else if (GLAD_GL_ARB_parallel_shader_compile) { glMaxShaderCompilerThreadsARB(0xFFFFFFFF); }
+
+	bool allLoaded = true;
+	std::vector<Pending> pending;
+
+	TRACE_BEGIN("submitShaders");
+	for (int i = 0; i < count; i++)
+	{
+		ShaderProgramSource &program = programs[i];
+		program.shader->id = 0;
+
+		std::string vertexSource;
+		std::string fragmentSource;
+		if (!readShaderFile(program.vertexShader, vertexSource) || !readShaderFile(program.fragmentShader, fragmentSource))
+		{
+			allLoaded = false;
+			continue;
+		}
+
+		Pending p = {&program, "", 0, 0};
+		if (useCache)
+		{
+			p.cachePath = programCachePath(vertexSource, fragmentSource);
+			GLuint id = loadProgramBinary(p.cachePath);
+			if (id)
+			{
+				program.shader->id = id;
+				program.shader->reflect();
+				continue;
+			}
+		}
+
+		const char *vertexData = vertexSource.c_str();
+		const char *fragmentData = fragmentSource.c_str();
+		p.vertexId = glCreateShader(GL_VERTEX_SHADER);
+		glShaderSource(p.vertexId, 1, &vertexData, nullptr);
+		glCompileShader(p.vertexId);
+		p.fragmentId = glCreateShader(GL_FRAGMENT_SHADER);
+		glShaderSource(p.fragmentId, 1, &fragmentData, nullptr);
+		glCompileShader(p.fragmentId);
+
+		GLuint id = glCreateProgram();
+		glAttachShader(id, p.vertexId);
+		glAttachShader(id, p.fragmentId);
+		if (useCache) { glProgramParameteri(id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE); }
+		glLinkProgram(id);
+		program.shader->id = id;
+
+		pending.push_back(p);
 	}
-	return uniform;
+	TRACE_END();
+
+	TRACE_SCOPE("waitShaders");
+	for (Pending &p : pending)
+	{
+		Shader &shader = *p.source->shader;
+
+		GLint info = 0;
+		glGetProgramiv(shader.id, GL_LINK_STATUS, &info);
+
+		if (info != GL_TRUE)
+		{
+			printShaderLog(p.vertexId, p.source->vertexShader);
+			printShaderLog(p.fragmentId, p.source->fragmentShader);
+
+			int l = 0;
+			glGetProgramiv(shader.id, GL_INFO_LOG_LENGTH, &l);
+			std::vector<char> message(l + 1);
+			glGetProgramInfoLog(shader.id, l, &l, message.data());
+			std::cout << std::string("Link error: ") + message.data() << "\n";
+
+			glDeleteProgram(shader.id);
+			shader.id = 0;
+			allLoaded = false;
+		}
+
+		glDeleteShader(p.vertexId);
+		glDeleteShader(p.fragmentId);
+
+		if (shader.id == 0) { continue; }
+
+		glValidateProgram(shader.id);
+		shader.reflect();
+
+		if (!p.cachePath.empty())
+		{
+			saveProgramBinary(shader.id, p.cachePath);
+		}
+	}
+
+	return allLoaded;
 }
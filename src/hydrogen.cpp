@@ -1,12 +1,47 @@
 #include "hydrogen.h"
+#include "Simd.h"
 #include <complex>
+#include <algorithm>
 #include <cmath>
 
 const double PI = 3.14159265358979323846;
 
-Hydrogen::Hydrogen(int n, int m, int l, int s) : n(n), m(m), l(l), s(s) {
-    a = 1 / sqrt(2 * PI);  // Bohr radius in atomic units
-    a0 = 0.52917721067; // Angstrom
+Hydrogen::Hydrogen(int n, int m, int l, int s, const Nucleus& nucleus) : n(n), m(m), l(l), s(s) {
+    a = nucleus.lengthScale();
+    a0 = 0.52917721067;
+    norm = pow(a, -1.5);
+
+    // R = N (2r/n)^l L(2r/n) e^(-r/n) with L the associated Laguerre polynomial L_{n-l-1}^{2l+1},
+    // expanded into one polynomial in r. Coefficients highest power first, for Horner.
+    int k = n - l - 1;
+    int alpha = 2 * l + 1;
+    if (k >= 0) {
+        double N = sqrt(pow(2.0 / n, 3) * tgamma(k + 1.0) / (2.0 * n * tgamma(n + l + 1.0))) * norm;
+        std::vector<double> c(n, 0.0);
+        for (int i = 0; i <= k; ++i) {
+            double binomial = tgamma(k + alpha + 1.0) / (tgamma(k - i + 1.0) * tgamma(alpha + i + 1.0));
+            c[l + i] = N * (i % 2 ? -1.0 : 1.0) * binomial / tgamma(i + 1.0) * pow(2.0 / n, l + i);
+        }
+        radialPoly.assign(c.rbegin(), c.rend());
+    }
+
+    // Theta = K d^|m|/dx^|m| P_l(x) sin^|m| theta, no Condon-Shortley phase, same as getTheta
+    int am = std::abs(m);
+    if (am <= l) {
+        std::vector<double> p(l + 1, 0.0);
+        for (int j = 0; 2 * j <= l; ++j) {
+            // Rodrigues: P_l = 2^-l sum_j (-1)^j C(l, j) C(2l - 2j, l) x^(l - 2j)
+            p[l - 2 * j] = (j % 2 ? -1.0 : 1.0) * tgamma(l + 1.0) / (tgamma(j + 1.0) * tgamma(l - j + 1.0))
+                           * tgamma(2.0 * l - 2.0 * j + 1.0) / (tgamma(l + 1.0) * tgamma(l - 2.0 * j + 1.0)) / pow(2.0, l);
+        }
+        for (int d = 0; d < am; ++d) {
+            for (int i = 0; i < l; ++i) p[i] = p[i + 1] * (i + 1);
+            p[l - d] = 0.0;
+        }
+        double K = sqrt((2 * l + 1) / 2.0 * tgamma(l - am + 1.0) / tgamma(l + am + 1.0));
+        for (double& coefficient : p) coefficient *= K;
+        polarPoly.assign(p.rbegin() + am, p.rend());
+    }
 }
 
 std::complex<double> Hydrogen::getP(double phi) {
@@ -38,9 +73,15 @@ double Hydrogen::getTheta(double theta) {
 }
 
 double Hydrogen::getR(double r)
+{
+	// R_Z,mu(r) = (Z mu)^(3/2) R(Z mu r)
+	return norm * getUnitR(r / a);
+}
+
+double Hydrogen::getUnitR(double r)
 {
 	//https://en.wikipedia.org/wiki/Hydrogen_atom#Solutions_of_the_Schr%C3%B6dinger_equation
-	// a0 = 1
+	// a0 = 1, every R is normalized so that the integral of R^2 r^2 dr is 1
 	switch (this->n)
 	{
 	case 1:
@@ -55,42 +96,118 @@ double Hydrogen::getR(double r)
 		{
 		case 0:
 			// 2s
-			return (1.0f / (2.0f * sqrt(2.0f))) * (2.0f - r) * exp(-r / 2.0f);
+			return (1.0 / (2.0 * sqrt(2.0))) * (2.0 - r) * exp(-r / 2.0);
 		case 1:
 			// 2p
-			return (1.0f / (2.0f * sqrt(6.0f))) * r * exp(-r / 2.0f);
+			return (1.0 / (2.0 * sqrt(6.0))) * r * exp(-r / 2.0);
 		}
 	case 3:
 		switch (this->l)
 		{
 		case 0:
 			// 3s
-			return (1.0f / (9.0f * sqrt(3.0f))) * (6.0f - 6.0f * r + (r*r)) * exp(-r / 3.0f);
+			return (2.0 / (81.0 * sqrt(3.0))) * (27.0 - 18.0 * r + 2.0 * (r*r)) * exp(-r / 3.0);
 		case 1:
 			// 3p
-			return (1.0f / (9.0f * sqrt(6.0f))) * (4.0f - (2.0f/3.0f)*r) * r * exp(-r / 3.0f);
+			return (8.0 / (27.0 * sqrt(6.0))) * (1.0 - r / 6.0) * r * exp(-r / 3.0);
 		case 2:
 			// 3d
-			return (1.0f / (9.0f * sqrt(30.0f))) * (r*r) * exp(-r / 3.0f);
+			return (4.0 / (81.0 * sqrt(30.0))) * (r*r) * exp(-r / 3.0);
 		}
 	case 4:
 		switch (this->l)
 		{
 		case 0:
 			// 4s
-			return (1.0f - 0.75f * r + 0.125f * (r*r) - (1.0f / 192.0f) * (r*r*r)) * exp(-r / 4.0f);
+			return 0.25 * (1.0 - 0.75 * r + 0.125 * (r*r) - (1.0 / 192.0) * (r*r*r)) * exp(-r / 4.0);
 		case 1:
 			// 4p
-			return (1.0f - 0.25f * r + 0.0125f * (r*r)) * r * exp(-r / 4.0f);
+			return (sqrt(5.0) / (16.0 * sqrt(3.0))) * (1.0 - 0.25 * r + 0.0125 * (r*r)) * r * exp(-r / 4.0);
 		case 2:
 			// 4d
-			return (1.0f - (1.0f / 12.0f) * r) * (r*r) * exp(-r / 4.0f);
+			return (1.0 / (64.0 * sqrt(5.0))) * (1.0 - (1.0 / 12.0) * r) * (r*r) * exp(-r / 4.0);
 		case 3:
 			// 4f
-			return (r*r*r) * exp(-r / 4.0f);
+			return (1.0 / (768.0 * sqrt(35.0))) * (r*r*r) * exp(-r / 4.0);
 		}
 	}
 
 
-	return 0.0f;
+	return 0.0;
+}
+
+static const size_t BATCH = 256; // a multiple of every Simd::WIDTH
+
+// y = c(x) for a whole batch, x and y hold BATCH floats so the last vector may run past count
+static void horner(const std::vector<float>& c, const float* x, float* y, size_t count) {
+    for (size_t i = 0; i < count; i += Simd::WIDTH) {
+        Simd::Float v = Simd::load(x + i);
+        Simd::Float sum = Simd::set(c[0]);
+        for (size_t k = 1; k < c.size(); ++k) sum = sum * v + Simd::set(c[k]);
+        Simd::store(y + i, sum);
+    }
+}
+
+void Hydrogen::getR(const float* r, float* out, size_t count, MathAccuracy accuracy) const {
+    if (radialPoly.empty()) {
+        std::fill(out, out + count, 0.0f);
+        return;
+    }
+    const float invA = (float)(1.0 / a);
+    const float decay = (float)(-1.0 / (n * a));
+    float rho[BATCH] = {}, arg[BATCH], poly[BATCH];
+    for (size_t begin = 0; begin < count; begin += BATCH) {
+        size_t block = std::min(BATCH, count - begin);
+        for (size_t i = 0; i < block; ++i) {
+            rho[i] = r[begin + i] * invA;
+            arg[i] = r[begin + i] * decay;
+        }
+        VectorMath::exp(arg, arg, block, accuracy);
+        horner(radialPoly, rho, poly, block);
+        for (size_t i = 0; i < block; ++i) out[begin + i] = poly[i] * arg[i];
+    }
+}
+
+void Hydrogen::getTheta(const float* theta, float* out, size_t count, MathAccuracy accuracy) const {
+    if (polarPoly.empty()) {
+        std::fill(out, out + count, 0.0f);
+        return;
+    }
+    const int am = std::abs(m);
+    if (l == 0) {
+        std::fill(out, out + count, polarPoly[0]);
+        return;
+    }
+    float sinT[BATCH], cosT[BATCH] = {}, poly[BATCH];
+    for (size_t begin = 0; begin < count; begin += BATCH) {
+        size_t block = std::min(BATCH, count - begin);
+        VectorMath::sincos(theta + begin, sinT, cosT, block, accuracy);
+        horner(polarPoly, cosT, poly, block);
+        for (size_t i = 0; i < block; ++i) {
+            float value = poly[i];
+            for (int k = 0; k < am; ++k) value *= sinT[i];
+            out[begin + i] = value;
+        }
+    }
+}
+
+void Hydrogen::radialPolynomial(int n, int l, const double* r, double* out, size_t count) {
+    const int k = n - l - 1;
+    if (k < 0) {
+        std::fill(out, out + count, 0.0);
+        return;
+    }
+    const double alpha = 2 * l + 1;
+    const double N = exp(0.5 * (3.0 * log(2.0 / n) + lgamma(k + 1.0) - log(2.0 * n) - lgamma(n + l + 1.0)));
+    for (size_t i = 0; i < count; ++i) {
+        double x = 2.0 * r[i] / n;
+        // L_0 = 1, L_1 = 1 + alpha - x, (j + 1) L_j+1 = (2j + 1 + alpha - x) L_j - (j + alpha) L_j-1
+        double previous = 0.0, L = 1.0;
+        for (int j = 0; j < k; ++j) {
+            double next = ((2 * j + 1 + alpha - x) * L - (j + alpha) * previous) / (j + 1);
+            previous = L;
+            L = next;
+        }
+        out[i] = N * pow(x, l) * L;
+    }
 }
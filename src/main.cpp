@@ -3,6 +3,7 @@
 #include <GLFW/glfw3.h>
 #include <openglDebug.h>
 #include <demoShaderLoader.h>
+#include <algorithm>
 #include <iostream>
 #include <vector>
 
@@ -10,29 +11,47 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include "AtomCloud.h"
 #include "Camera.h"
-#include <random>
-#include <algorithm>
-#include "hydrogen.h"
+#include "DensityRenderer.h"
+#include "DepthSorter.h"
+#include "FrameCapture.h"
+#include "FrameGovernor.h"
+#include "GeometryGenerator.h"
+#include "LevelOfDetail.h"
+#include "Nucleus.h"
+#include "OrbitalComparison.h"
+#include "OrbitalGenerator.h"
+#include "Profiler.h"
+#include "QuantumNumbers.h"
+#include "RedrawScheduler.h"
+#include "RenderSettings.h"
+#include "RenderTarget.h"
+#include "SampleStream.h"
+#include "Trace.h"
+#include "UIManager.h"
 #include "imgui.h"
 #include "backends/imgui_impl_glfw.h"
 #include "backends/imgui_impl_opengl3.h"
 
 // Hint to use dedicated GPU
+#ifdef _WIN32
 extern "C"
 {
     __declspec(dllexport) unsigned long NvOptimusEnablement = 1;
     __declspec(dllexport) int AmdPowerXpressRequestHighPerformance = 1;
 }
+#endif
 
 // Function prototypes
 void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
+void mouse_button_callback(GLFWwindow* window, int button, int action, int mods);
+void window_refresh_callback(GLFWwindow* window);
+void window_focus_callback(GLFWwindow* window, int focused);
 void processInput(GLFWwindow *window);
-void generateOrbital(int n, int l, int m, int s);
-void generateSphere(std::vector<float>& vertices, std::vector<unsigned int>& indices, float radius, int sectors, int stacks);
 
 // Camera
 Camera camera(glm::vec3(0.0f, 0.0f, 3.0f));
@@ -45,17 +64,20 @@ float deltaTime = 0.0f;
 float lastFrame = 0.0f;
 
 // Quantum numbers
-int n = 1, l = 0, m = 0, s = 1; // s: 1=Up, -1=Down, 0=Both
+QuantumNumbers qn;
+Nucleus nucleus;
 bool orbitalNeedsUpdate = true;
 
+// Idle mode: frames are only drawn while something is invalidated
+RedrawScheduler redraw;
+
 // Orbital data
-unsigned int orbitalVAO, orbitalPosVBO, orbitalColorVBO;
-std::vector<glm::vec3> orbitalPoints;
-std::vector<glm::vec3> orbitalColors;
-int numOrbitalPoints = 0;
+unsigned int orbitalVAO, orbitalPosVBO, orbitalColorVBO, orbitalEBO;
+unsigned int streamVAO, streamPosVBO, streamColorVBO;
 
 int main(void)
 {
+    TRACE_THREAD_NAME("main");
     if (!glfwInit())
         return -1;
 
@@ -63,7 +85,9 @@ int main(void)
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-    glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, true);
+    // a debug context costs validation even when nothing listens, only ask for one when needed
+    GLDebugMode debugMode = getDefaultGLDebugMode();
+    glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, debugMode != GLDebugMode::Off);
 
     GLFWwindow* window = glfwCreateWindow(1280, 720, "Hydrogen Atom Visualizer", NULL, NULL);
     if (!window)
@@ -77,36 +101,51 @@ int main(void)
     glfwSetCursorPosCallback(window, mouse_callback);
     glfwSetScrollCallback(window, scroll_callback);
     glfwSetKeyCallback(window, key_callback);
+    // set before ImGui installs its own, it chains to these
+    glfwSetMouseButtonCallback(window, mouse_button_callback);
+    glfwSetWindowRefreshCallback(window, window_refresh_callback);
+    glfwSetWindowFocusCallback(window, window_focus_callback);
 
     gladLoadGLLoader((GLADloadproc)glfwGetProcAddress);
     glfwSwapInterval(1);
 
-    glEnable(GL_DEBUG_OUTPUT);
-    glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
-    glDebugMessageCallback(glDebugOutput, 0);
-    glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DONT_CARE, 0, nullptr, GL_TRUE);
+    setGLDebugMode(debugMode);
+    double lastDebugFlush = 0.0;
 
     glEnable(GL_DEPTH_TEST);
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
     glEnable(GL_PROGRAM_POINT_SIZE);
 
+    double shaderStart = glfwGetTime();
     Shader lightingShader;
-    lightingShader.loadShaderProgramFromFile(RESOURCES_PATH "vertex.vert", RESOURCES_PATH "fragment.frag");
-
     Shader nucleusShader;
-    nucleusShader.loadShaderProgramFromFile(RESOURCES_PATH "vertex.vert", RESOURCES_PATH "nucleus.frag");
+    ShaderProgramSource programs[] = {
+        {&lightingShader, RESOURCES_PATH "vertex.vert", RESOURCES_PATH "fragment.frag"},
+        {&nucleusShader, RESOURCES_PATH "vertex.vert", RESOURCES_PATH "nucleus.frag"},
+    };
+    loadShaderProgramsFromFiles(programs, 2);
+    double shaderTime = glfwGetTime() - shaderStart;
+    bool firstFrame = true;
+
+    GLint nucleusModelLoc = nucleusShader.getUniform("model");
+    GLint lightingModelLoc = lightingShader.getUniform("model");
+
+    // projection + view, uploaded once per frame and shared by every program
+    UniformBuffer cameraUBO;
+    cameraUBO.create(2 * sizeof(glm::mat4), CAMERA_BLOCK_BINDING);
 
     IMGUI_CHECKVERSION();
     ImGui::CreateContext();
     ImGuiIO& io = ImGui::GetIO(); (void)io;
+    io.ConfigFlags |= ImGuiConfigFlags_DockingEnable;
     ImGui::StyleColorsDark();
     ImGui_ImplGlfw_InitForOpenGL(window, true);
     ImGui_ImplOpenGL3_Init(glsl_version);
 
     std::vector<float> vertices;
     std::vector<unsigned int> indices;
-    generateSphere(vertices, indices, 0.1f, 36, 18);
+    GeometryGenerator::generateSphere(vertices, indices, 0.1f, 36, 18);
 
     unsigned int nucleusVBO, nucleusVAO, nucleusEBO;
     glGenVertexArrays(1, &nucleusVAO);
@@ -125,6 +164,7 @@ int main(void)
     glGenVertexArrays(1, &orbitalVAO);
     glGenBuffers(1, &orbitalPosVBO);
     glGenBuffers(1, &orbitalColorVBO);
+    glGenBuffers(1, &orbitalEBO);
 
     glBindVertexArray(orbitalVAO);
     glBindBuffer(GL_ARRAY_BUFFER, orbitalPosVBO);
@@ -133,82 +173,383 @@ int main(void)
     glBindBuffer(GL_ARRAY_BUFFER, orbitalColorVBO);
     glEnableVertexAttribArray(1);
     glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, orbitalEBO);
+
+    // progressive refinement streams fresh batches through these, only one batch is ever resident
+    glGenVertexArrays(1, &streamVAO);
+    glGenBuffers(1, &streamPosVBO);
+    glGenBuffers(1, &streamColorVBO);
+
+    glBindVertexArray(streamVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, streamPosVBO);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+    glBindBuffer(GL_ARRAY_BUFFER, streamColorVBO);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+
+    OrbitalGenerator orbitalGenerator(orbitalVAO, orbitalPosVBO, orbitalColorVBO);
+    UIManager uiManager;
+    FrameCapture frameCapture;
+    RenderSettings renderSettings;
+
+    DensityRenderer densityRenderer;
+    densityRenderer.init();
+
+    // back-to-front order for translucent points, drawn through orbitalEBO
+    DepthSorter depthSorter;
+    std::vector<unsigned int> sortedIndices;
+    GLsizei sortedCount = 0;
+    bool sortNeeded = true;
+    glm::mat4 lastSortedView(0.0f);
+    int lastSortedCount = 0;
+    GLint lightingAlphaLoc = lightingShader.getUniform("alpha");
+    GLint lightingPointSizeLoc = lightingShader.getUniform("pointSize");
+
+    LevelOfDetail lod;
+    RenderStats renderStats;
+
+    // internal resolution is only used when the governor picks a scale other than 1
+    FrameGovernor governor;
+    governor.init();
+    RenderTarget sceneTarget;
+    bool adaptiveQuality = renderSettings.adaptiveQuality;
+
+    Profiler profiler;
+
+    bool sortPending = false;
+
+    // comparison mode replaces the single cloud with every state of a subshell or shell
+    OrbitalComparison comparison;
+    comparison.init();
+    ComparisonMode shownComparison = ComparisonMode::Off;
+    ComparisonLayout shownLayout = renderSettings.comparisonLayout;
+
+    // whole atom view, takes precedence over the comparison
+    AtomCloud atomCloud;
+    atomCloud.init();
+    AtomSettings atomSettings;
+    bool atomNeedsUpdate = true;
+
+    // hybrid set of the single cloud, hybridCount is 0 while a plain orbital is shown
+    HybridSet hybridSet;
+    int hybridCount = 0;
+
+    SampleStream sampleStream;
+    std::vector<glm::vec3> streamPoints;
+    std::vector<glm::vec3> streamColors;
+    bool streamSourceValid = false;
+    bool accumulationValid = false;
+    glm::mat4 accumulatedCamera[2];
+    glm::mat4 accumulatedModel;
 
     while (!glfwWindowShouldClose(window))
     {
+        // aggregated GL debug messages are printed in batches instead of from the callback
+        if (getGLDebugMode() == GLDebugMode::Aggregated && glfwGetTime() - lastDebugFlush > 2.0) {
+            flushGLDebugMessages();
+            lastDebugFlush = glfwGetTime();
+        }
+
+        // nothing changed: sleep until an event invalidates the image, the timeout only
+        // keeps the housekeeping above going
+        if (renderSettings.idleRedraw && !redraw.needsRedraw()) {
+            TRACE_SCOPE("idle");
+            glfwWaitEventsTimeout(1.0);
+            continue;
+        }
+        renderStats.redrawReasons = renderSettings.idleRedraw ? redraw.beginFrame() : 0;
+        renderStats.framesRendered++;
+
+        // after an idle stretch the time since the last frame says nothing about frame pacing
         float currentFrame = (float)glfwGetTime();
-        deltaTime = currentFrame - lastFrame;
+        deltaTime = std::min(currentFrame - lastFrame, 0.1f);
         lastFrame = currentFrame;
 
+        TRACE_SCOPE("frame");
         processInput(window);
-
-        if (orbitalNeedsUpdate) {
-            generateOrbital(n, l, m, s);
+        governor.beginFrame();
+        profiler.beginFrame();
+
+        bool atomView = atomSettings.enabled;
+        bool comparing = !atomView && shownComparison != ComparisonMode::Off;
+        if (atomView) {
+            // a pending single orbital update waits until the view is left
+            if (atomCloud.getSeed() != renderSettings.sampler.seed) atomNeedsUpdate = true;
+            if (atomNeedsUpdate) {
+                ProfileScope scope(profiler, "Sampling", false);
+                // neutral atom, the nuclear charge equals the electron count
+                atomCloud.update(atomSettings.configuration, ElectronConfiguration::electronCount(atomSettings.configuration), atomSettings.pointBudget,
+                                 renderSettings.sampler.seed);
+                atomNeedsUpdate = false;
+            }
+        } else if (orbitalNeedsUpdate && comparing) {
+            ProfileScope scope(profiler, "Sampling", false);
+            comparison.generate(OrbitalComparison::statesFor(shownComparison, qn), renderSettings.trials, renderSettings.sampler);
+            orbitalNeedsUpdate = false;
+        } else if (orbitalNeedsUpdate) {
+            orbitalGenerator.setTrials(renderSettings.trials);
+            orbitalGenerator.setSamplerOptions(renderSettings.sampler);
+            orbitalGenerator.setAdaptive(renderSettings.adaptive, renderSettings.adaptiveTarget);
+            {
+                ProfileScope scope(profiler, "Sampling", false);
+                hybridCount = HybridOrbital::preset(renderSettings.hybrid, qn.n, hybridSet) ? hybridSet.getHybridCount() : 0;
+                if (hybridCount > 0) {
+                    orbitalGenerator.sampleHybrid(hybridSet);
+                } else {
+                    orbitalGenerator.sample(qn);
+                }
+                depthSorter.setPoints(orbitalGenerator.getOrbitalPoints());
+                renderStats.adaptive = renderSettings.adaptive ? orbitalGenerator.getAdaptiveResult() : AdaptiveResult();
+            }
+            {
+                ProfileScope scope(profiler, "Upload");
+                orbitalGenerator.upload();
+            }
+            sortedCount = 0;
+            sortNeeded = true;
+            streamSourceValid = false;
+            accumulationValid = false;
             orbitalNeedsUpdate = false;
         }
 
-        glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
         ImGui_ImplOpenGL3_NewFrame();
         ImGui_ImplGlfw_NewFrame();
         ImGui::NewFrame();
 
-        ImGui::Begin("Controls");
-        ImGui::Text("Quantum Numbers");
-        if (ImGui::SliderInt("n", &n, 1, 4)) orbitalNeedsUpdate = true;
-        if (l >= n) l = n - 1;
-        if (ImGui::SliderInt("l", &l, 0, n > 0 ? n - 1 : 0)) orbitalNeedsUpdate = true;
-        if (m > l) m = l;
-        if (m < -l) m = -l;
-        if (ImGui::SliderInt("m", &m, -l, l)) orbitalNeedsUpdate = true;
-        ImGui::Separator();
-        ImGui::Text("Spin (s)");
-        if (ImGui::RadioButton("Up", &s, 1)) orbitalNeedsUpdate = true;
-        ImGui::SameLine();
-        if (ImGui::RadioButton("Down", &s, -1)) orbitalNeedsUpdate = true;
-        ImGui::SameLine();
-        if (ImGui::RadioButton("Both", &s, 0)) orbitalNeedsUpdate = true;
-        ImGui::End();
+        uiManager.drawUI(qn, nucleus, orbitalNeedsUpdate);
+        uiManager.drawCaptureUI(frameCapture);
+        uiManager.drawRenderUI(renderSettings, renderStats, qn, orbitalNeedsUpdate);
+        uiManager.drawAtomUI(atomSettings, atomCloud, atomNeedsUpdate);
+        uiManager.drawExpectationUI(qn);
+        uiManager.drawTransitionUI();
+        uiManager.drawProfilerUI(profiler);
+        uiManager.drawDebugUI();
+        if (renderSettings.comparison != shownComparison) {
+            shownComparison = renderSettings.comparison;
+            orbitalNeedsUpdate = true;
+        }
+        if (renderSettings.comparisonLayout != shownLayout) {
+            shownLayout = renderSettings.comparisonLayout;
+            comparison.setLayout(shownLayout);
+            redraw.invalidate(RedrawScheduler::Orbital);
+        }
+        if (orbitalNeedsUpdate || atomNeedsUpdate) redraw.invalidate(RedrawScheduler::Orbital);
+        if (ImGui::IsAnyItemActive()) redraw.invalidate(RedrawScheduler::Interface);
+        if (frameCapture.isRecording() || frameCapture.getPendingReadbacks() > 0) redraw.invalidate(RedrawScheduler::Animation);
+
+        if (renderSettings.adaptiveQuality != adaptiveQuality) {
+            adaptiveQuality = renderSettings.adaptiveQuality;
+            governor.reset();
+        }
+        governor.setTargetMs(renderSettings.frameBudgetMs);
+        FrameGovernor::Level quality = adaptiveQuality ? governor.getLevel() : FrameGovernor::Level{1.0f, 1.0f};
 
         int width, height;
         glfwGetFramebufferSize(window, &width, &height);
-        glm::mat4 projection = glm::perspective(glm::radians(camera.zoom), (float)width / (float)height, 0.1f, 100.0f);
-        glm::mat4 view = camera.getViewMatrix();
+        int renderWidth = std::max(1, (int)(width * quality.renderScale));
+        int renderHeight = std::max(1, (int)(height * quality.renderScale));
+        bool scaled = quality.renderScale != 1.0f && width > 0 && height > 0;
+        if (scaled) {
+            sceneTarget.resize(renderWidth, renderHeight);
+            sceneTarget.bind();
+        } else {
+            renderWidth = width;
+            renderHeight = height;
+        }
+
+        glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        glm::mat4 cameraBlock[2] = {
+            glm::perspective(glm::radians(camera.zoom), (float)width / (float)height, 0.1f, 100.0f),
+            camera.getViewMatrix()
+        };
+        cameraUBO.update(cameraBlock);
         glm::mat4 model = glm::mat4(1.0f);
+        // clouds are sampled for Z = 1, other nuclei stretch them (the atom view scales its own subshells)
+        float lengthScale = renderSettings.trueScale ? (float)nucleus.lengthScale() : 1.0f;
+        glm::mat4 cloudModel = glm::scale(model, glm::vec3(lengthScale));
+
+        {
+            ProfileScope scope(profiler, "Nucleus");
+            nucleusShader.bind();
+            glUniformMatrix4fv(nucleusModelLoc, 1, GL_FALSE, glm::value_ptr(model));
+            glBindVertexArray(nucleusVAO);
+            glDrawElements(GL_TRIANGLES, (GLsizei)indices.size(), GL_UNSIGNED_INT, 0);
+        }
+
+        // point size is in internal pixels, scale it so points keep their size on screen
+        int totalPoints = atomView ? atomCloud.getTotalPoints() : comparing ? comparison.getTotalPoints() : orbitalGenerator.getNumOrbitalPoints();
+        float cloudRadius = atomView ? atomCloud.getCloudRadius() : lengthScale * (comparing ? comparison.getExtent() : orbitalGenerator.getCloudRadius());
+        float basePointSize = std::max(1.0f, 2.0f * quality.renderScale);
+        float pointsPerPixel = renderSettings.lodEnabled ? renderSettings.lodPointsPerPixel / (quality.renderScale * quality.renderScale) : 0.0f;
+        LodSelection lodSelection = lod.select(totalPoints, cloudRadius, glm::length(camera.position),
+                                               glm::radians(camera.zoom), renderHeight, pointsPerPixel, basePointSize,
+                                               renderSettings.pointAlpha, quality.pointScale);
+        renderStats.drawnPoints = lodSelection.drawCount;
+        renderStats.totalPoints = totalPoints;
+        renderStats.pointSize = lodSelection.pointSize;
+        renderStats.renderWidth = renderWidth;
+        renderStats.renderHeight = renderHeight;
+        renderStats.comparedOrbitals = comparing ? comparison.getOrbitalCount() : 0;
+        renderStats.hybridCount = atomView || comparing ? 0 : hybridCount;
+
+        if (atomView) {
+            ProfileScope scope(profiler, "Points");
+            // drawn as points in either mode; subshells overlap, so no depth sort here either
+            float fraction = totalPoints > 0 ? (float)lodSelection.drawCount / (float)totalPoints : 1.0f;
+            bool translucent = renderSettings.pointAlpha < 1.0f;
+            if (translucent) glDepthMask(GL_FALSE);
+            atomCloud.draw(model, fraction, lodSelection.pointSize, lodSelection.alpha);
+            if (translucent) glDepthMask(GL_TRUE);
+        } else if (comparing) {
+            ProfileScope scope(profiler, "Points");
+            // one multi-draw for every orbital; no depth sort, translucent points just skip depth writes
+            float fraction = totalPoints > 0 ? (float)lodSelection.drawCount / (float)totalPoints : 1.0f;
+            bool translucent = renderSettings.pointAlpha < 1.0f;
+            if (translucent) glDepthMask(GL_FALSE);
+            comparison.draw(cloudModel, fraction, lodSelection.pointSize, lodSelection.alpha);
+            if (translucent) glDepthMask(GL_TRUE);
+        } else if (renderSettings.mode == RenderMode::Density && renderSettings.progressive) {
+            ProfileScope scope(profiler, "Points");
+            bool still = accumulationValid && cameraBlock[0] == accumulatedCamera[0] && cameraBlock[1] == accumulatedCamera[1] &&
+                         cloudModel == accumulatedModel;
+            if (!still) {
+                // moving or changed: start over from the resident cloud
+                densityRenderer.resetAccumulation();
+                densityRenderer.accumulate(orbitalVAO, lodSelection.drawCount, renderWidth, renderHeight, cloudModel);
+                accumulatedCamera[0] = cameraBlock[0];
+                accumulatedCamera[1] = cameraBlock[1];
+                accumulatedModel = cloudModel;
+                accumulationValid = true;
+            } else if (densityRenderer.getAccumulatedFrames() < renderSettings.progressiveFrames) {
+                if (!streamSourceValid) {
+                    if (hybridCount > 0) {
+                        sampleStream.setSource(hybridSet, renderSettings.trials, renderSettings.sampler.seed);
+                    } else {
+                        sampleStream.setSource(qn, renderSettings.trials, renderSettings.sampler);
+                    }
+                    streamSourceValid = true;
+                }
+                if (sampleStream.fetch(streamPoints, streamColors)) {
+                    glBindBuffer(GL_ARRAY_BUFFER, streamPosVBO);
+                    glBufferData(GL_ARRAY_BUFFER, streamPoints.size() * sizeof(glm::vec3), streamPoints.data(), GL_STREAM_DRAW);
+                    glBindBuffer(GL_ARRAY_BUFFER, streamColorVBO);
+                    glBufferData(GL_ARRAY_BUFFER, streamColors.size() * sizeof(glm::vec3), streamColors.data(), GL_STREAM_DRAW);
+                    densityRenderer.accumulate(streamVAO, (GLsizei)streamPoints.size(), renderWidth, renderHeight, cloudModel);
+                }
+            }
+            if (densityRenderer.getAccumulatedFrames() < renderSettings.progressiveFrames) redraw.invalidate(RedrawScheduler::Progressive);
+            densityRenderer.resolve(renderSettings.exposure);
+            renderStats.accumulatedFrames = densityRenderer.getAccumulatedFrames();
+        } else if (renderSettings.mode == RenderMode::Density) {
+            ProfileScope scope(profiler, "Points");
+            // the splat weight divides by the drawn count, a smaller prefix keeps the same brightness
+            densityRenderer.render(orbitalVAO, lodSelection.drawCount, renderWidth, renderHeight, cloudModel, renderSettings.exposure);
+            accumulationValid = false;
+        } else {
+            bool translucent = renderSettings.pointAlpha < 1.0f;
+            if (translucent) {
+                glm::mat4 modelView = cameraBlock[1] * cloudModel;
+                if (sortNeeded || modelView != lastSortedView || lodSelection.drawCount != lastSortedCount) {
+                    depthSorter.requestSort(modelView, lodSelection.drawCount);
+                    sortPending = true;
+                    lastSortedView = modelView;
+                    lastSortedCount = lodSelection.drawCount;
+                    sortNeeded = false;
+                }
+                if (depthSorter.fetchOrder(sortedIndices)) {
+                    ProfileScope scope(profiler, "Upload");
+                    glBindVertexArray(orbitalVAO);
+                    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sortedIndices.size() * sizeof(unsigned int), sortedIndices.data(), GL_STREAM_DRAW);
+                    sortedCount = (GLsizei)sortedIndices.size();
+                    sortPending = false;
+                }
+                // the sorted order arrives on a later frame, keep drawing until it does
+                if (sortPending) redraw.invalidate(RedrawScheduler::Progressive);
+                renderStats.lastSortMs = depthSorter.getLastSortMs();
+                renderStats.lastSortIncremental = depthSorter.getLastSortIncremental();
+            }
+
+            ProfileScope scope(profiler, "Points");
+            lightingShader.bind();
+            glUniformMatrix4fv(lightingModelLoc, 1, GL_FALSE, glm::value_ptr(cloudModel));
+            glUniform1f(lightingAlphaLoc, lodSelection.alpha);
+            glUniform1f(lightingPointSizeLoc, lodSelection.pointSize);
+            glBindVertexArray(orbitalVAO);
+            if (translucent && sortedCount > 0) {
+                // sorted order already resolves visibility, depth writes would cut blended points.
+                // While a sort for a new LOD count is pending the previous prefix is drawn.
+                glDepthMask(GL_FALSE);
+                glDrawElements(GL_POINTS, sortedCount, GL_UNSIGNED_INT, 0);
+                glDepthMask(GL_TRUE);
+            } else {
+                glDrawArrays(GL_POINTS, 0, lodSelection.drawCount);
+            }
+        }
 
-        nucleusShader.bind();
-        glUniformMatrix4fv(glGetUniformLocation(nucleusShader.id, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
-        glUniformMatrix4fv(glGetUniformLocation(nucleusShader.id, "view"), 1, GL_FALSE, glm::value_ptr(view));
-        glUniformMatrix4fv(glGetUniformLocation(nucleusShader.id, "model"), 1, GL_FALSE, glm::value_ptr(model));
-        glBindVertexArray(nucleusVAO);
-        glDrawElements(GL_TRIANGLES, (GLsizei)indices.size(), GL_UNSIGNED_INT, 0);
-
-        lightingShader.bind();
-        glUniformMatrix4fv(glGetUniformLocation(lightingShader.id, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
-        glUniformMatrix4fv(glGetUniformLocation(lightingShader.id, "view"), 1, GL_FALSE, glm::value_ptr(view));
-        glUniformMatrix4fv(glGetUniformLocation(lightingShader.id, "model"), 1, GL_FALSE, glm::value_ptr(model));
-        glBindVertexArray(orbitalVAO);
-        glPointSize(2.0f);
-        glDrawArrays(GL_POINTS, 0, numOrbitalPoints);
-
-        ImGui::Render();
-        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
-
-        glfwSwapBuffers(window);
+        if (scaled) {
+            ProfileScope scope(profiler, "Scale blit");
+            sceneTarget.blitToDefault(width, height);
+        }
+
+        {
+            ProfileScope scope(profiler, "Capture");
+            frameCapture.capture(width, height);
+        }
+
+        {
+            ProfileScope scope(profiler, "ImGui");
+            ImGui::Render();
+            ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        }
+
+        profiler.endFrame();
+        governor.endFrame();
+        renderStats.cpuMs = governor.getCpuMs();
+        renderStats.gpuMs = governor.getGpuMs();
+        renderStats.qualityLevel = governor.getLevelIndex();
+        renderStats.qualityLevelCount = governor.getLevelCount();
+        renderStats.pointScale = quality.pointScale;
+        renderStats.renderScale = quality.renderScale;
+
+        {
+            TRACE_SCOPE("swap");
+            glfwSwapBuffers(window);
+        }
         glfwPollEvents();
+
+        if (firstFrame) {
+            // glfwGetTime counts from glfwInit
+            std::cout << "First frame after " << (int)(glfwGetTime() * 1000.0) << " ms (shaders " << (int)(shaderTime * 1000.0) << " ms)\n";
+            firstFrame = false;
+        }
     }
 
+    frameCapture.clear();
+
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
     ImGui::DestroyContext();
 
+    densityRenderer.clear();
+    comparison.clear();
+    atomCloud.clear();
+    sceneTarget.clear();
+    governor.clear();
+    profiler.clear();
+    cameraUBO.clear();
     glDeleteVertexArrays(1, &nucleusVAO);
     glDeleteBuffers(1, &nucleusVBO);
     glDeleteBuffers(1, &nucleusEBO);
     glDeleteVertexArrays(1, &orbitalVAO);
     glDeleteBuffers(1, &orbitalPosVBO);
     glDeleteBuffers(1, &orbitalColorVBO);
+    glDeleteBuffers(1, &orbitalEBO);
+    glDeleteVertexArrays(1, &streamVAO);
+    glDeleteBuffers(1, &streamPosVBO);
+    glDeleteBuffers(1, &streamColorVBO);
 
     glfwTerminate();
     return 0;
@@ -218,6 +559,10 @@ void processInput(GLFWwindow *window)
 {
     if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
         glfwSetWindowShouldClose(window, true);
+    // held keys send no events after the first, keep drawing while one is down
+    if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS || glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS ||
+        glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS || glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
+        redraw.invalidate(RedrawScheduler::Camera);
     if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
         camera.processKeyboard("FORWARD", deltaTime);
     if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
@@ -230,8 +575,16 @@ void processInput(GLFWwindow *window)
 
 void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods)
 {
+    redraw.invalidate(RedrawScheduler::Interface, 3);
     if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS)
         glfwSetWindowShouldClose(window, GLFW_TRUE);
+#ifdef HYDROGEN_TRACING
+    if (key == GLFW_KEY_F9 && action == GLFW_PRESS)
+    {
+        std::string path = Trace::dump();
+        std::cout << (path.empty() ? "Trace dump failed" : "Trace written to " + path) << "\n";
+    }
+#endif
 }
 
 void mouse_callback(GLFWwindow* window, double xpos, double ypos)
@@ -246,130 +599,37 @@ void mouse_callback(GLFWwindow* window, double xpos, double ypos)
     float yoffset = lastY - (float)ypos;
     lastX = (float)xpos;
     lastY = (float)ypos;
+    redraw.invalidate(RedrawScheduler::Interface, 2);
     if (glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS)
     {
         camera.processMouseMovement(xoffset, yoffset);
+        redraw.invalidate(RedrawScheduler::Camera);
     }
 }
 
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
 {
     camera.processMouseScroll((float)yoffset);
+    redraw.invalidate(RedrawScheduler::Camera | RedrawScheduler::Interface, 2);
 }
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height)
 {
     glViewport(0, 0, width, height);
+    redraw.invalidate(RedrawScheduler::Window);
 }
 
-void generateOrbital(int n, int l, int m, int s) {
-    orbitalPoints.clear();
-    orbitalColors.clear();
-    Hydrogen h(n, m, l, s);
-
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_real_distribution<> dis(0.0, 1.0);
-
-    double max_r = n * n * 2.5;
-    double max_prob = 0.0;
-    for (int i = 0; i < 10000; ++i) {
-        double r = dis(gen) * max_r;
-        double theta = dis(gen) * 3.14159265;
-        double prob = std::pow(h.getR(r), 2) * std::pow(h.getTheta(theta), 2);
-        if (prob > max_prob) {
-            max_prob = prob;
-        }
-    }
-    if (max_prob == 0.0) max_prob = 1.0;
-
-    glm::vec3 color_up(0.2f, 0.5f, 1.0f);
-    glm::vec3 color_down(1.0f, 0.3f, 0.2f);
-
-    for (int i = 0; i < 50000; ++i) {
-        double r = dis(gen) * max_r;
-        double theta = dis(gen) * 3.14159265;
-        double phi = dis(gen) * 2 * 3.14159265;
-
-        double prob = std::pow(h.getR(r), 2) * std::pow(h.getTheta(theta), 2);
-
-        if (prob / max_prob > dis(gen)) {
-            float x = (float)(r * sin(theta) * cos(phi));
-            float y = (float)(r * sin(theta) * sin(phi));
-            float z = (float)(r * cos(theta));
-            orbitalPoints.push_back(glm::vec3(x, y, z));
-
-            if (s == 1) {
-                orbitalColors.push_back(color_up);
-            } else if (s == -1) {
-                orbitalColors.push_back(color_down);
-            } else { // s == 0 (Both)
-                orbitalColors.push_back((dis(gen) > 0.5) ? color_up : color_down);
-            }
-        }
-    }
-
-    numOrbitalPoints = orbitalPoints.size();
-
-    glBindVertexArray(orbitalVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, orbitalPosVBO);
-    glBufferData(GL_ARRAY_BUFFER, orbitalPoints.size() * sizeof(glm::vec3), orbitalPoints.data(), GL_STATIC_DRAW);
-    glBindBuffer(GL_ARRAY_BUFFER, orbitalColorVBO);
-    glBufferData(GL_ARRAY_BUFFER, orbitalColors.size() * sizeof(glm::vec3), orbitalColors.data(), GL_STATIC_DRAW);
+void mouse_button_callback(GLFWwindow* window, int button, int action, int mods)
+{
+    redraw.invalidate(RedrawScheduler::Interface, 3);
 }
 
-void generateSphere(std::vector<float>& vertices, std::vector<unsigned int>& indices, float radius, int sectors, int stacks)
+void window_refresh_callback(GLFWwindow* window)
 {
-    vertices.clear();
-    indices.clear();
-
-    const float PI = 3.14159265359f;
-    float x, y, z, xy;
-    float nx, ny, nz, lengthInv = 1.0f / radius;
-
-    float sectorStep = 2 * PI / sectors;
-    float stackStep = PI / stacks;
-    float sectorAngle, stackAngle;
-
-    for (int i = 0; i <= stacks; ++i)
-    {
-        stackAngle = PI / 2 - i * stackStep;
-        xy = radius * cosf(stackAngle);
-        z = radius * sinf(stackAngle);
-
-        for (int j = 0; j <= sectors; ++j)
-        {
-            sectorAngle = j * sectorStep;
-
-            x = xy * cosf(sectorAngle);
-            y = xy * sinf(sectorAngle);
-            vertices.push_back(x);
-            vertices.push_back(y);
-            vertices.push_back(z);
-
-            nx = x * lengthInv;
-            ny = y * lengthInv;
-            nz = z * lengthInv;
-            vertices.push_back(nx);
-            vertices.push_back(ny);
-            vertices.push_back(nz);
-        }
-    }
-
-    for (int i = 0; i < stacks; ++i)
-    {
-        for (int j = 0; j < sectors; ++j)
-        {
-            int k1 = i * (sectors + 1) + j;
-            int k2 = k1 + sectors + 1;
-
-            indices.push_back(k1);
-            indices.push_back(k2);
-            indices.push_back(k1 + 1);
+    redraw.invalidate(RedrawScheduler::Window);
+}
 
-            indices.push_back(k1 + 1);
-            indices.push_back(k2);
-            indices.push_back(k2 + 1);
-        }
-    }
+void window_focus_callback(GLFWwindow* window, int focused)
+{
+    redraw.invalidate(RedrawScheduler::Interface, 2);
 }
@@ -1,5 +1,59 @@
 #include <openglDebug.h>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <sstream>
+
+static bool isIgnored(unsigned int id)
+{
+	return id == 131169 || id == 131185 || id == 131218 || id == 131204
+		|| id == 131222
+		|| id == 131140; //dittering error
+}
+
+static const char *sourceName(GLenum source)
+{
+	switch (source)
+	{
+	case GL_DEBUG_SOURCE_API:             return "API";
+	case GL_DEBUG_SOURCE_WINDOW_SYSTEM:   return "Window System";
+	case GL_DEBUG_SOURCE_SHADER_COMPILER: return "Shader Compiler";
+	case GL_DEBUG_SOURCE_THIRD_PARTY:     return "Third Party";
+	case GL_DEBUG_SOURCE_APPLICATION:     return "Application";
+	case GL_DEBUG_SOURCE_OTHER:           return "Other";
+	}
+	return "Unknown";
+}
+
+static const char *typeName(GLenum type)
+{
+	switch (type)
+	{
+	case GL_DEBUG_TYPE_ERROR:               return "Error";
+	case GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR: return "Deprecated Behaviour";
+	case GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR:  return "Undefined Behaviour";
+	case GL_DEBUG_TYPE_PORTABILITY:         return "Portability";
+	case GL_DEBUG_TYPE_PERFORMANCE:         return "Performance";
+	case GL_DEBUG_TYPE_MARKER:              return "Marker";
+	case GL_DEBUG_TYPE_PUSH_GROUP:          return "Push Group";
+	case GL_DEBUG_TYPE_POP_GROUP:           return "Pop Group";
+	case GL_DEBUG_TYPE_OTHER:               return "Other";
+	}
+	return "Unknown";
+}
+
+static const char *severityName(GLenum severity)
+{
+	switch (severity)
+	{
+	case GL_DEBUG_SEVERITY_HIGH:         return "high";
+	case GL_DEBUG_SEVERITY_MEDIUM:       return "medium";
+	case GL_DEBUG_SEVERITY_LOW:          return "low";
+	case GL_DEBUG_SEVERITY_NOTIFICATION: return "notification";
+	}
+	return "unknown";
+}
 
 //https://learnopengl.com/In-Practice/Debugging
 void GLAPIENTRY glDebugOutput(GLenum source,
@@ -10,45 +64,192 @@ void GLAPIENTRY glDebugOutput(GLenum source,
 	const char *message,
 	const void *userParam)
 {
-	if (id == 131169 || id == 131185 || id == 131218 || id == 131204
-		|| id == 131222
-		|| id == 131140 //dittering error
-		) return;
+	if (isIgnored(id)) return;
 	if (type == GL_DEBUG_TYPE_PERFORMANCE) return;
 
+	//built first and written once, no flush per line
+	std::ostringstream out;
+	out << "---------------\n";
+	out << "Debug message (" << id << "): " << message << "\n";
+	out << "Source: " << sourceName(source) << "\n";
+	out << "Type: " << typeName(type) << "\n";
+	out << "Severity: " << severityName(severity) << "\n";
+	std::cout << out.str();
+}
 
-	std::cout << "---------------" << std::endl;
-	std::cout << "Debug message (" << id << "): " << message << std::endl;
+//open addressing table keyed by id, slots are claimed with a CAS and never freed, so the
+//callback (which may run on any driver thread) never takes a lock
+static const int TABLE_SIZE = 256;
+static const int MESSAGE_LENGTH = 160;
 
-	switch (source)
+struct CounterSlot
+{
+	std::atomic<unsigned int> key{0}; //id + 1, 0 marks an empty slot
+	std::atomic<bool> ready{false};   //set once the fields below are written
+	std::atomic<unsigned int> count{0};
+	unsigned int flushedCount = 0;    //only touched by flushGLDebugMessages
+	GLenum source = 0;
+	GLenum type = 0;
+	GLenum severity = 0;
+	char message[MESSAGE_LENGTH] = {};
+};
+
+static CounterSlot counterTable[TABLE_SIZE];
+static std::atomic<unsigned int> droppedMessages{0};
+static GLDebugMode currentMode = GLDebugMode::Off;
+
+static void GLAPIENTRY glDebugAggregate(GLenum source,
+	GLenum type,
+	unsigned int id,
+	GLenum severity,
+	GLsizei length,
+	const char *message,
+	const void *userParam)
+{
+	if (isIgnored(id)) return;
+
+	unsigned int key = id + 1;
+	unsigned int start = (id * 2654435761u) % TABLE_SIZE;
+	for (int probe = 0; probe < TABLE_SIZE; probe++)
 	{
-	case GL_DEBUG_SOURCE_API:             std::cout << "Source: API"; break;
-	case GL_DEBUG_SOURCE_WINDOW_SYSTEM:   std::cout << "Source: Window System"; break;
-	case GL_DEBUG_SOURCE_SHADER_COMPILER: std::cout << "Source: Shader Compiler"; break;
-	case GL_DEBUG_SOURCE_THIRD_PARTY:     std::cout << "Source: Third Party"; break;
-	case GL_DEBUG_SOURCE_APPLICATION:     std::cout << "Source: Application"; break;
-	case GL_DEBUG_SOURCE_OTHER:           std::cout << "Source: Other"; break;
-	} std::cout << std::endl;
+		CounterSlot &slot = counterTable[(start + probe) % TABLE_SIZE];
+		unsigned int current = slot.key.load(std::memory_order_acquire);
+		if (current == 0)
+		{
+			if (slot.key.compare_exchange_strong(current, key, std::memory_order_acq_rel))
+			{
+				slot.source = source;
+				slot.type = type;
+				slot.severity = severity;
+				strncpy(slot.message, message, MESSAGE_LENGTH - 1);
+				size_t end = strlen(slot.message);
+				while (end > 0 && (slot.message[end - 1] == '\n' || slot.message[end - 1] == '\r')) { slot.message[--end] = 0; }
+				slot.ready.store(true, std::memory_order_release);
+				slot.count.fetch_add(1, std::memory_order_relaxed);
+				return;
+			}
+			//lost the race, current now holds the winner's key
+		}
+		if (current == key)
+		{
+			slot.count.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+	}
+	droppedMessages.fetch_add(1, std::memory_order_relaxed);
+}
 
-	switch (type)
+GLDebugMode getDefaultGLDebugMode()
+{
+	const char *env = std::getenv("HYDROGEN_GL_DEBUG");
+	if (env)
 	{
-	case GL_DEBUG_TYPE_ERROR:               std::cout << "Type: Error"; break;
-	case GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR: std::cout << "Type: Deprecated Behaviour"; break;
-	case GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR:  std::cout << "Type: Undefined Behaviour"; break;
-	case GL_DEBUG_TYPE_PORTABILITY:         std::cout << "Type: Portability"; break;
-	case GL_DEBUG_TYPE_PERFORMANCE:         std::cout << "Type: Performance"; break;
-	case GL_DEBUG_TYPE_MARKER:              std::cout << "Type: Marker"; break;
-	case GL_DEBUG_TYPE_PUSH_GROUP:          std::cout << "Type: Push Group"; break;
-	case GL_DEBUG_TYPE_POP_GROUP:           std::cout << "Type: Pop Group"; break;
-	case GL_DEBUG_TYPE_OTHER:               std::cout << "Type: Other"; break;
-	} std::cout << std::endl;
+		if (strcmp(env, "off") == 0) { return GLDebugMode::Off; }
+		if (strcmp(env, "aggregated") == 0) { return GLDebugMode::Aggregated; }
+		if (strcmp(env, "sync") == 0) { return GLDebugMode::Synchronous; }
+	}
+#ifdef NDEBUG
+	return GLDebugMode::Off;
+#else
+	return GLDebugMode::Aggregated;
+#endif
+}
 
-	switch (severity)
+void setGLDebugMode(GLDebugMode mode)
+{
+	if (!glDebugMessageCallback || !glDebugMessageControl) { mode = GLDebugMode::Off; }
+
+	if (mode == GLDebugMode::Off)
+	{
+		if (glDebugMessageCallback)
+		{
+			glDisable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+			glDisable(GL_DEBUG_OUTPUT);
+		}
+		currentMode = mode;
+		return;
+	}
+
+	glEnable(GL_DEBUG_OUTPUT);
+	if (mode == GLDebugMode::Synchronous)
+	{
+		glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+		glDebugMessageCallback(glDebugOutput, 0);
+	}
+	else
+	{
+		glDisable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+		glDebugMessageCallback(glDebugAggregate, 0);
+	}
+	glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DONT_CARE, 0, nullptr, GL_TRUE);
+	currentMode = mode;
+}
+
+GLDebugMode getGLDebugMode()
+{
+	return currentMode;
+}
+
+const char *getGLDebugModeName(GLDebugMode mode)
+{
+	switch (mode)
 	{
-	case GL_DEBUG_SEVERITY_HIGH:         std::cout << "Severity: high"; break;
-	case GL_DEBUG_SEVERITY_MEDIUM:       std::cout << "Severity: medium"; break;
-	case GL_DEBUG_SEVERITY_LOW:          std::cout << "Severity: low"; break;
-	case GL_DEBUG_SEVERITY_NOTIFICATION: std::cout << "Severity: notification"; break;
-	};
+	case GLDebugMode::Off:         return "Off";
+	case GLDebugMode::Aggregated:  return "Aggregated";
+	case GLDebugMode::Synchronous: return "Synchronous";
+	}
+	return "Unknown";
+}
+
+int getGLDebugCounters(GLDebugCounter *counters, int maxCounters)
+{
+	int written = 0;
+	for (int i = 0; i < TABLE_SIZE && written < maxCounters; i++)
+	{
+		CounterSlot &slot = counterTable[i];
+		if (!slot.ready.load(std::memory_order_acquire)) { continue; }
+
+		GLDebugCounter &counter = counters[written++];
+		counter.id = slot.key.load(std::memory_order_relaxed) - 1;
+		counter.source = slot.source;
+		counter.type = slot.type;
+		counter.severity = slot.severity;
+		counter.count = slot.count.load(std::memory_order_relaxed);
+		counter.message = slot.message;
+	}
+	return written;
+}
+
+unsigned int getGLDebugDroppedMessages()
+{
+	return droppedMessages.load(std::memory_order_relaxed);
+}
+
+void resetGLDebugCounters()
+{
+	//ids stay in the table (slots are never freed), only the counts start over
+	for (CounterSlot &slot : counterTable)
+	{
+		slot.count.store(0, std::memory_order_relaxed);
+		slot.flushedCount = 0;
+	}
+	droppedMessages.store(0, std::memory_order_relaxed);
+}
+
+void flushGLDebugMessages()
+{
+	std::ostringstream out;
+	for (CounterSlot &slot : counterTable)
+	{
+		if (!slot.ready.load(std::memory_order_acquire)) { continue; }
+
+		unsigned int count = slot.count.load(std::memory_order_relaxed);
+		if (count == slot.flushedCount) { continue; }
 
-}
\ No newline at end of file
+		out << "GL debug (" << slot.key.load(std::memory_order_relaxed) - 1 << ", " << typeName(slot.type) << ", "
+			<< severityName(slot.severity) << ") x" << count - slot.flushedCount << ": " << slot.message << "\n";
+		slot.flushedCount = count;
+	}
+	std::string text = out.str();
+	if (!text.empty()) { std::cout << text; }
+}
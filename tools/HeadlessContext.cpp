@@ -0,0 +1,78 @@
+#include "HeadlessContext.h"
+#include <glad/glad.h>
+#include <EGL/eglext.h>
+#include <iostream>
+
+static EGLDisplay display = EGL_NO_DISPLAY;
+
+bool HeadlessContext::initDisplay() {
+    if (display != EGL_NO_DISPLAY) return true;
+
+    auto getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if (getPlatformDisplay) {
+        display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+    }
+    if (display == EGL_NO_DISPLAY) {
+        display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    }
+
+    EGLint major = 0, minor = 0;
+    if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor)) {
+        std::cout << "EGL error: could not initialize a display (0x" << std::hex << eglGetError() << std::dec << ")\n";
+        display = EGL_NO_DISPLAY;
+        return false;
+    }
+
+    if (!eglBindAPI(EGL_OPENGL_API)) {
+        std::cout << "EGL error: desktop OpenGL is not supported\n";
+        terminateDisplay();
+        return false;
+    }
+    return true;
+}
+
+void HeadlessContext::terminateDisplay() {
+    if (display == EGL_NO_DISPLAY) return;
+    eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    eglTerminate(display);
+    display = EGL_NO_DISPLAY;
+}
+
+bool HeadlessContext::loadGL() {
+    return gladLoadGLLoader((GLADloadproc)eglGetProcAddress) != 0;
+}
+
+HeadlessContext::~HeadlessContext() {
+    destroy();
+}
+
+bool HeadlessContext::create() {
+    const EGLint attribs[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 3,
+        EGL_CONTEXT_MINOR_VERSION, 3,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+    };
+
+    // no config and no surface, we only ever render into FBOs
+    context_ = eglCreateContext(display, EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, attribs);
+    if (context_ == EGL_NO_CONTEXT) {
+        std::cout << "EGL error: could not create a GL 3.3 core context (0x" << std::hex << eglGetError() << std::dec << ")\n";
+        return false;
+    }
+    return true;
+}
+
+bool HeadlessContext::makeCurrent() {
+    return eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context_) == EGL_TRUE;
+}
+
+void HeadlessContext::release() {
+    eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+}
+
+void HeadlessContext::destroy() {
+    if (context_ == EGL_NO_CONTEXT) return;
+    eglDestroyContext(display, context_);
+    context_ = EGL_NO_CONTEXT;
+}
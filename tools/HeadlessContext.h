@@ -0,0 +1,30 @@
+#ifndef HEADLESS_CONTEXT_H
+#define HEADLESS_CONTEXT_H
+
+#include <EGL/egl.h>
+
+// Window-less GL 3.3 core context on the EGL surfaceless platform (Mesa llvmpipe works).
+// Rendering goes to an FBO; each render thread owns one context.
+class HeadlessContext {
+public:
+    // Opens the process wide EGL display, call once before creating contexts
+    static bool initDisplay();
+    static void terminateDisplay();
+    // glad loader, needs a current context
+    static bool loadGL();
+
+    HeadlessContext() = default;
+    ~HeadlessContext();
+    HeadlessContext(const HeadlessContext&) = delete;
+    HeadlessContext& operator=(const HeadlessContext&) = delete;
+
+    bool create();
+    bool makeCurrent();
+    void release();
+    void destroy();
+
+private:
+    EGLContext context_ = EGL_NO_CONTEXT;
+};
+
+#endif // HEADLESS_CONTEXT_H
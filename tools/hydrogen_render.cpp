@@ -0,0 +1,428 @@
+// Offscreen batch renderer: renders a camera path for a list of orbitals into image sequences.
+//
+//   hydrogen_render -o frames --turntable 120 2,1,0 3,2,1
+//   hydrogen_render -o frames --path orbit.txt --all 3 --format raw
+//
+// Every state is rendered by its own worker (one EGL context each), frames go to a
+// background encoder thread so rendering never waits on disk I/O.
+
+#include <glad/glad.h>
+#include "HeadlessContext.h"
+#include <demoShaderLoader.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "Expectation.h"
+#include "FrameWriter.h"
+#include "GeometryGenerator.h"
+#include "OrbitalGenerator.h"
+#include "QuantumNumbers.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct CameraKey {
+    glm::vec3 eye;
+    float fov;
+};
+
+struct RenderOptions {
+    std::string outDir = "frames";
+    int width = 1280;
+    int height = 720;
+    int turntableFrames = 120;
+    float elevation = 20.0f;
+    std::string pathFile;
+    std::vector<CameraKey> path; // absolute camera path, empty means turntable
+    int threads = 0;
+    int encoders = 0; // 0 = half the render threads
+    FrameFormat format = FrameFormat::PNG;
+    uint64_t seed = Random::DEFAULT_SEED;
+    int trials = 50000;
+    std::vector<QuantumNumbers> states;
+};
+
+static void printUsage() {
+    std::cout <<
+        "usage: hydrogen_render [options] n,l,m[,s] ...\n"
+        "  -o DIR           output directory (default: frames)\n"
+        "  --size WxH       image size (default: 1280x720)\n"
+        "  --turntable N    orbit the nucleus in N frames (default: 120)\n"
+        "  --elevation DEG  turntable elevation (default: 20)\n"
+        "  --path FILE      camera path, one frame per line: x y z [fov], camera looks at the nucleus\n"
+        "  --all N          render every state with n <= N\n"
+        "  --threads T      render threads (default: one per core)\n"
+        "  --encoders E     PNG encoder threads (default: half the render threads)\n"
+        "  --format png|raw image format (default: png)\n"
+        "  --seed S         sampler seed, same seed gives the same frames (default: 1)\n"
+        "  --trials T       sampler candidates per state (default: 50000)\n";
+}
+
+static bool parseState(const char* text, QuantumNumbers& qn) {
+    int n = 0, l = 0, m = 0, s = 1;
+    int count = sscanf(text, "%d,%d,%d,%d", &n, &l, &m, &s);
+    if (count < 3) return false;
+    if (n < 1 || n > 4 || l < 0 || l >= n || m < -l || m > l) return false;
+    if (s != 1 && s != -1 && s != 0) return false;
+    qn = QuantumNumbers(n, l, m, s);
+    return true;
+}
+
+static bool loadCameraPath(const std::string& file, std::vector<CameraKey>& path) {
+    std::ifstream f(file);
+    if (!f.is_open()) {
+        std::cout << "Error opening file: " << file << "\n";
+        return false;
+    }
+
+    std::string line;
+    while (std::getline(f, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        std::istringstream in(line);
+        CameraKey key;
+        key.fov = 45.0f;
+        if (!(in >> key.eye.x >> key.eye.y >> key.eye.z)) continue;
+        in >> key.fov;
+        path.push_back(key);
+    }
+
+    if (path.empty()) {
+        std::cout << "Camera path is empty: " << file << "\n";
+        return false;
+    }
+    return true;
+}
+
+static bool parseOptions(int argc, char** argv, RenderOptions& options) {
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (!strcmp(arg, "-h") || !strcmp(arg, "--help")) {
+            return false;
+        } else if (!strcmp(arg, "-o") && hasValue) {
+            options.outDir = argv[++i];
+        } else if (!strcmp(arg, "--size") && hasValue) {
+            if (sscanf(argv[++i], "%dx%d", &options.width, &options.height) != 2 || options.width <= 0 || options.height <= 0) {
+                std::cout << "Invalid size: " << argv[i] << "\n";
+                return false;
+            }
+        } else if (!strcmp(arg, "--turntable") && hasValue) {
+            options.turntableFrames = std::max(1, atoi(argv[++i]));
+        } else if (!strcmp(arg, "--elevation") && hasValue) {
+            options.elevation = (float)atof(argv[++i]);
+        } else if (!strcmp(arg, "--path") && hasValue) {
+            options.pathFile = argv[++i];
+        } else if (!strcmp(arg, "--all") && hasValue) {
+            int maxN = std::min(4, std::max(1, atoi(argv[++i])));
+            for (int n = 1; n <= maxN; ++n)
+                for (int l = 0; l < n; ++l)
+                    for (int m = -l; m <= l; ++m)
+                        options.states.push_back(QuantumNumbers(n, l, m, 1));
+        } else if (!strcmp(arg, "--threads") && hasValue) {
+            options.threads = std::max(1, atoi(argv[++i]));
+        } else if (!strcmp(arg, "--encoders") && hasValue) {
+            options.encoders = std::max(1, atoi(argv[++i]));
+        } else if (!strcmp(arg, "--seed") && hasValue) {
+            options.seed = strtoull(argv[++i], nullptr, 10);
+        } else if (!strcmp(arg, "--trials") && hasValue) {
+            options.trials = std::max(1, atoi(argv[++i]));
+        } else if (!strcmp(arg, "--format") && hasValue) {
+            const char* format = argv[++i];
+            if (!strcmp(format, "png")) options.format = FrameFormat::PNG;
+            else if (!strcmp(format, "raw")) options.format = FrameFormat::Raw;
+            else {
+                std::cout << "Unknown format: " << format << "\n";
+                return false;
+            }
+        } else {
+            QuantumNumbers qn;
+            if (!parseState(arg, qn)) {
+                std::cout << "Invalid argument or state: " << arg << "\n";
+                return false;
+            }
+            options.states.push_back(qn);
+        }
+    }
+
+    if (!options.pathFile.empty() && !loadCameraPath(options.pathFile, options.path)) {
+        return false;
+    }
+    if (options.states.empty()) {
+        std::cout << "No states to render\n";
+        return false;
+    }
+    return true;
+}
+
+static std::string stateName(const QuantumNumbers& qn) {
+    const char* spin = qn.s == 1 ? "up" : (qn.s == -1 ? "down" : "both");
+    return "n" + std::to_string(qn.n) + "_l" + std::to_string(qn.l) + "_m" + std::to_string(qn.m) + "_" + spin;
+}
+
+static std::vector<CameraKey> turntable(const RenderOptions& options, const QuantumNumbers& qn) {
+    // a few mean radii keep the visible cloud in frame, the sampling radius reaches far into the faint tail
+    float distance = (float)Expectation::get(qn)->meanR * 3.5f;
+    float elevation = glm::radians(options.elevation);
+
+    std::vector<CameraKey> path;
+    for (int i = 0; i < options.turntableFrames; ++i) {
+        float angle = 2.0f * glm::pi<float>() * i / options.turntableFrames;
+        CameraKey key;
+        key.eye = distance * glm::vec3(cos(elevation) * sin(angle), sin(elevation), cos(elevation) * cos(angle));
+        key.fov = 45.0f;
+        path.push_back(key);
+    }
+    return path;
+}
+
+class StateRenderer {
+public:
+    bool init(int width, int height) {
+        width_ = width;
+        height_ = height;
+
+        glGenFramebuffers(1, &fbo_);
+        glGenRenderbuffers(1, &colorRBO_);
+        glGenRenderbuffers(1, &depthRBO_);
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
+        glBindRenderbuffer(GL_RENDERBUFFER, colorRBO_);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorRBO_);
+        glBindRenderbuffer(GL_RENDERBUFFER, depthRBO_);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthRBO_);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+            std::cout << "Framebuffer is not complete\n";
+            return false;
+        }
+        glViewport(0, 0, width, height);
+
+        ShaderProgramSource programs[] = {
+            {&lightingShader_, RESOURCES_PATH "vertex.vert", RESOURCES_PATH "fragment.frag"},
+            {&nucleusShader_, RESOURCES_PATH "vertex.vert", RESOURCES_PATH "nucleus.frag"},
+        };
+        if (!loadShaderProgramsFromFiles(programs, 2)) return false;
+        nucleusModelLoc_ = nucleusShader_.getUniform("model");
+        lightingModelLoc_ = lightingShader_.getUniform("model");
+        cameraUBO_.create(2 * sizeof(glm::mat4), CAMERA_BLOCK_BINDING);
+
+        glEnable(GL_DEPTH_TEST);
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        glPointSize(2.0f);
+
+        std::vector<float> vertices;
+        std::vector<unsigned int> indices;
+        GeometryGenerator::generateSphere(vertices, indices, 0.1f, 36, 18);
+        nucleusIndexCount_ = (GLsizei)indices.size();
+
+        glGenVertexArrays(1, &nucleusVAO_);
+        glGenBuffers(1, &nucleusVBO_);
+        glGenBuffers(1, &nucleusEBO_);
+        glBindVertexArray(nucleusVAO_);
+        glBindBuffer(GL_ARRAY_BUFFER, nucleusVBO_);
+        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, nucleusEBO_);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
+        glEnableVertexAttribArray(1);
+
+        glGenVertexArrays(1, &orbitalVAO_);
+        glGenBuffers(1, &orbitalPosVBO_);
+        glGenBuffers(1, &orbitalColorVBO_);
+        glBindVertexArray(orbitalVAO_);
+        glBindBuffer(GL_ARRAY_BUFFER, orbitalPosVBO_);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+        glBindBuffer(GL_ARRAY_BUFFER, orbitalColorVBO_);
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        return true;
+    }
+
+    void upload(const std::vector<glm::vec3>& points, const std::vector<glm::vec3>& colors) {
+        numOrbitalPoints_ = (GLsizei)points.size();
+        glBindBuffer(GL_ARRAY_BUFFER, orbitalPosVBO_);
+        glBufferData(GL_ARRAY_BUFFER, points.size() * sizeof(glm::vec3), points.data(), GL_STATIC_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, orbitalColorVBO_);
+        glBufferData(GL_ARRAY_BUFFER, colors.size() * sizeof(glm::vec3), colors.data(), GL_STATIC_DRAW);
+    }
+
+    void render(const CameraKey& key, float farPlane, unsigned char* pixels) {
+        glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        glm::mat4 cameraBlock[2] = {
+            glm::perspective(glm::radians(key.fov), (float)width_ / (float)height_, 0.1f, farPlane),
+            glm::lookAt(key.eye, glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f))
+        };
+        cameraUBO_.update(cameraBlock);
+        glm::mat4 model = glm::mat4(1.0f);
+
+        nucleusShader_.bind();
+        glUniformMatrix4fv(nucleusModelLoc_, 1, GL_FALSE, glm::value_ptr(model));
+        glBindVertexArray(nucleusVAO_);
+        glDrawElements(GL_TRIANGLES, nucleusIndexCount_, GL_UNSIGNED_INT, 0);
+
+        lightingShader_.bind();
+        glUniformMatrix4fv(lightingModelLoc_, 1, GL_FALSE, glm::value_ptr(model));
+        glBindVertexArray(orbitalVAO_);
+        glDrawArrays(GL_POINTS, 0, numOrbitalPoints_);
+
+        glReadPixels(0, 0, width_, height_, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+    }
+
+    void clear() {
+        lightingShader_.clear();
+        nucleusShader_.clear();
+        cameraUBO_.clear();
+        glDeleteVertexArrays(1, &nucleusVAO_);
+        glDeleteBuffers(1, &nucleusVBO_);
+        glDeleteBuffers(1, &nucleusEBO_);
+        glDeleteVertexArrays(1, &orbitalVAO_);
+        glDeleteBuffers(1, &orbitalPosVBO_);
+        glDeleteBuffers(1, &orbitalColorVBO_);
+        glDeleteRenderbuffers(1, &colorRBO_);
+        glDeleteRenderbuffers(1, &depthRBO_);
+        glDeleteFramebuffers(1, &fbo_);
+    }
+
+private:
+    int width_ = 0;
+    int height_ = 0;
+    GLuint fbo_ = 0, colorRBO_ = 0, depthRBO_ = 0;
+    GLuint nucleusVAO_ = 0, nucleusVBO_ = 0, nucleusEBO_ = 0;
+    GLuint orbitalVAO_ = 0, orbitalPosVBO_ = 0, orbitalColorVBO_ = 0;
+    GLsizei nucleusIndexCount_ = 0;
+    GLsizei numOrbitalPoints_ = 0;
+    Shader lightingShader_;
+    Shader nucleusShader_;
+    GLint lightingModelLoc_ = -1;
+    GLint nucleusModelLoc_ = -1;
+    UniformBuffer cameraUBO_;
+};
+
+int main(int argc, char** argv)
+{
+    RenderOptions options;
+    if (!parseOptions(argc, argv, options)) {
+        printUsage();
+        return 1;
+    }
+
+    if (!HeadlessContext::initDisplay()) return -1;
+
+    int threadCount = options.threads ? options.threads : (int)std::thread::hardware_concurrency();
+    threadCount = std::max(1, std::min(threadCount, (int)options.states.size()));
+
+    std::vector<HeadlessContext> contexts(threadCount);
+    for (auto& context : contexts) {
+        if (!context.create()) {
+            HeadlessContext::terminateDisplay();
+            return -1;
+        }
+    }
+
+    contexts[0].makeCurrent();
+    if (!HeadlessContext::loadGL()) {
+        std::cout << "Could not load OpenGL functions\n";
+        HeadlessContext::terminateDisplay();
+        return -1;
+    }
+    // push() blocks on a full queue, so encoders scale with the renderers or a slow PNG encode stalls them all
+    const int encoderCount = options.encoders ? options.encoders : std::max(1, threadCount / 2);
+    std::cout << "Renderer: " << glGetString(GL_RENDERER) << ", " << threadCount << " render threads, " << encoderCount << " encoders\n";
+    contexts[0].release();
+
+    FrameWriter writer(options.format, 4 * threadCount + 16, encoderCount);
+    std::atomic<int> nextState(0);
+    std::atomic<bool> failed(false);
+    std::mutex logMutex;
+    const size_t frameSize = (size_t)options.width * options.height * 4;
+
+    auto start = std::chrono::steady_clock::now();
+
+    auto worker = [&](int index) {
+        HeadlessContext& context = contexts[index];
+        context.makeCurrent();
+
+        StateRenderer renderer;
+        if (!renderer.init(options.width, options.height)) {
+            failed = true;
+        }
+
+        std::vector<glm::vec3> points;
+        std::vector<glm::vec3> colors;
+        int i;
+        while (!failed && (i = nextState++) < (int)options.states.size()) {
+            const QuantumNumbers& qn = options.states[i];
+            std::filesystem::path dir = std::filesystem::path(options.outDir) / stateName(qn);
+            std::error_code ec;
+            std::filesystem::create_directories(dir, ec);
+
+            SamplerOptions sampler;
+            sampler.seed = options.seed;
+            // one sampler thread, the render threads already keep every core busy
+            OrbitalGenerator::sampleOrbital(qn, points, colors, options.trials, 1, sampler);
+            renderer.upload(points, colors);
+
+            std::vector<CameraKey> path = options.path.empty() ? turntable(options, qn) : options.path;
+            float farPlane = (float)OrbitalGenerator::samplingRadius(qn) * 10.0f;
+
+            for (size_t f = 0; f < path.size(); ++f) {
+                Frame frame;
+                char name[32];
+                snprintf(name, sizeof(name), "frame_%04d", (int)f);
+                frame.path = (dir / name).string();
+                frame.width = options.width;
+                frame.height = options.height;
+                frame.pixels = writer.acquireBuffer(frameSize);
+                renderer.render(path[f], farPlane, frame.pixels.data());
+                writer.push(std::move(frame));
+            }
+
+            std::lock_guard<std::mutex> lock(logMutex);
+            std::cout << stateName(qn) << ": " << points.size() << " points, " << path.size() << " frames\n";
+        }
+
+        renderer.clear();
+        context.release();
+    };
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threadCount; ++t) {
+        workers.emplace_back(worker, t);
+    }
+    for (auto& t : workers) {
+        t.join();
+    }
+    writer.flush();
+
+    float seconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+    std::cout << writer.getFramesWritten() << " frames written to " << options.outDir << " in " << seconds << "s\n";
+
+    for (auto& context : contexts) {
+        context.destroy();
+    }
+    HeadlessContext::terminateDisplay();
+    return failed ? -1 : 0;
+}
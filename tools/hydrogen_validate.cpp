@@ -0,0 +1,474 @@
+// Statistical check of the orbital sampler: draws a large cloud per state and tests the r,
+// theta and phi marginals against |psi|^2 with Kolmogorov-Smirnov and chi-square tests.
+// Hybrid sets get the r and theta tests on the whole cloud and a test of the hybrids' shares.
+// Also checks the VectorMath error bounds. Exits non-zero if anything fails.
+//
+//   hydrogen_validate --all 4
+//   hydrogen_validate --trials 8000000 --evaluator vector --accuracy fast 3,2,1 4,3,0 --hybrid sp3,2
+//
+// States run in parallel, one per core, each sampled on a single thread so the reported
+// throughput is per core.
+
+#include "hydrogen.h"
+#include "HybridOrbital.h"
+#include "OrbitalGenerator.h"
+#include "QuantumNumbers.h"
+#include "Simd.h"
+#include "VectorMath.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+static const double PI = 3.14159265358979323846;
+
+struct ValidateOptions {
+    int trials = 2000000;
+    int threads = 0;
+    double alpha = 0.01;  // family-wise, split over every test (Bonferroni)
+    double maxTail = 1e-3; // largest probability the sampling radius may cut off
+    SamplerOptions sampler;
+    std::vector<QuantumNumbers> states;
+    std::vector<std::pair<HybridType, int>> hybrids; // type and shell
+};
+
+static const HybridType HYBRID_TYPES[] = {HybridType::SP, HybridType::SP2, HybridType::SP3, HybridType::DSP3};
+
+static void printUsage() {
+    std::cout <<
+        "usage: hydrogen_validate [options] n,l,m ...\n"
+        "  --all N              every state and hybrid set with n <= N\n"
+        "  --hybrid T,n         hybrid set sp|sp2|sp3|dsp3 of shell n\n"
+        "  --trials T           candidates per state (default: 2000000)\n"
+        "  --evaluator E        exact|table|vector (default: exact)\n"
+        "  --accuracy A         precise|fast|visual (default: precise)\n"
+        "  --seed S             sampler seed (default: 1)\n"
+        "  --alpha A            family-wise significance (default: 0.01)\n"
+        "  --threads T          worker threads (default: one per core)\n";
+}
+
+static bool parseState(const char* text, QuantumNumbers& qn) {
+    int n = 0, l = 0, m = 0;
+    if (sscanf(text, "%d,%d,%d", &n, &l, &m) != 3) return false;
+    if (n < 1 || n > 4 || l < 0 || l >= n || m < -l || m > l) return false;
+    qn = QuantumNumbers(n, l, m, 1);
+    return true;
+}
+
+static bool parseOptions(int argc, char** argv, ValidateOptions& options) {
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (!strcmp(arg, "-h") || !strcmp(arg, "--help")) {
+            return false;
+        } else if (!strcmp(arg, "--all") && hasValue) {
+            int maxN = std::min(4, std::max(1, atoi(argv[++i])));
+            for (int n = 1; n <= maxN; ++n)
+                for (int l = 0; l < n; ++l)
+                    for (int m = -l; m <= l; ++m)
+                        options.states.push_back(QuantumNumbers(n, l, m, 1));
+            for (int n = 2; n <= maxN; ++n)
+                for (HybridType type : HYBRID_TYPES) {
+                    HybridSet set;
+                    if (HybridOrbital::preset(type, n, set)) options.hybrids.push_back(std::make_pair(type, n));
+                }
+        } else if (!strcmp(arg, "--hybrid") && hasValue) {
+            const char* text = argv[++i];
+            const char* comma = strchr(text, ',');
+            int n = comma ? atoi(comma + 1) : 0;
+            std::string name = comma ? std::string(text, comma) : std::string(text);
+            bool found = false;
+            for (HybridType type : HYBRID_TYPES) {
+                HybridSet set;
+                if (name == HybridOrbital::name(type) && n <= 4 && HybridOrbital::preset(type, n, set)) {
+                    options.hybrids.push_back(std::make_pair(type, n));
+                    found = true;
+                }
+            }
+            if (!found) {
+                std::cout << "Invalid hybrid set: " << text << "\n";
+                return false;
+            }
+        } else if (!strcmp(arg, "--trials") && hasValue) {
+            options.trials = std::max(1000, atoi(argv[++i]));
+        } else if (!strcmp(arg, "--evaluator") && hasValue) {
+            const char* name = argv[++i];
+            if (!strcmp(name, "exact")) options.sampler.evaluator = OrbitalEvaluator::Exact;
+            else if (!strcmp(name, "table")) options.sampler.evaluator = OrbitalEvaluator::Table;
+            else if (!strcmp(name, "vector")) options.sampler.evaluator = OrbitalEvaluator::Vector;
+            else {
+                std::cout << "Unknown evaluator: " << name << "\n";
+                return false;
+            }
+        } else if (!strcmp(arg, "--accuracy") && hasValue) {
+            const char* name = argv[++i];
+            bool found = false;
+            for (MathAccuracy tier : {MathAccuracy::Precise, MathAccuracy::Fast, MathAccuracy::Visual}) {
+                if (!strcmp(name, VectorMath::name(tier))) {
+                    options.sampler.accuracy = tier;
+                    found = true;
+                }
+            }
+            if (!found) {
+                std::cout << "Unknown accuracy: " << name << "\n";
+                return false;
+            }
+        } else if (!strcmp(arg, "--seed") && hasValue) {
+            options.sampler.seed = strtoull(argv[++i], nullptr, 10);
+        } else if (!strcmp(arg, "--alpha") && hasValue) {
+            options.alpha = atof(argv[++i]);
+        } else if (!strcmp(arg, "--threads") && hasValue) {
+            options.threads = std::max(1, atoi(argv[++i]));
+        } else {
+            QuantumNumbers qn;
+            if (!parseState(arg, qn)) {
+                std::cout << "Invalid argument or state: " << arg << "\n";
+                return false;
+            }
+            options.states.push_back(qn);
+        }
+    }
+    if (options.states.empty() && options.hybrids.empty()) {
+        std::cout << "No states to validate\n";
+        return false;
+    }
+    return true;
+}
+
+// Tabulated CDF of a density on [lo, hi], Simpson per interval, normalized to its end value
+class TabulatedCdf {
+public:
+    template <typename Density>
+    TabulatedCdf(const Density& density, double lo, double hi, int intervals = 1 << 16)
+        : lo_(lo), step_((hi - lo) / intervals), cdf_(intervals + 1) {
+        double left = density(lo);
+        cdf_[0] = 0.0;
+        for (int i = 0; i < intervals; ++i) {
+            double x = lo + i * step_;
+            double right = density(x + step_);
+            cdf_[i + 1] = cdf_[i] + step_ / 6.0 * (left + 4.0 * density(x + 0.5 * step_) + right);
+            left = right;
+        }
+        mass_ = cdf_.back();
+        for (double& c : cdf_) c /= mass_;
+    }
+
+    double operator()(double x) const {
+        double t = (x - lo_) / step_;
+        if (t <= 0.0) return 0.0;
+        size_t i = (size_t)t;
+        if (i >= cdf_.size() - 1) return 1.0;
+        double f = t - i;
+        return cdf_[i] + f * (cdf_[i + 1] - cdf_[i]);
+    }
+
+    double getMass() const { return mass_; } // integral before normalizing
+
+private:
+    double lo_;
+    double step_;
+    double mass_ = 0.0;
+    std::vector<double> cdf_;
+};
+
+// Largest distance between the empirical and the model CDF, sorts values
+template <typename Cdf>
+static double ksDistance(std::vector<float>& values, const Cdf& cdf) {
+    std::sort(values.begin(), values.end());
+    const double n = (double)values.size();
+    double d = 0.0;
+    for (size_t i = 0; i < values.size(); ++i) {
+        double c = cdf(values[i]);
+        d = std::max(d, std::max(c - i / n, (i + 1) / n - c));
+    }
+    return d;
+}
+
+// Asymptotic Kolmogorov distribution with the small sample correction of Stephens
+static double ksPValue(double d, size_t n) {
+    double sqrtN = std::sqrt((double)n);
+    double lambda = (sqrtN + 0.12 + 0.11 / sqrtN) * d;
+    if (lambda < 0.2) return 1.0;
+    double sum = 0.0;
+    for (int k = 1; k <= 100; ++k) {
+        double term = 2.0 * ((k % 2) ? 1.0 : -1.0) * std::exp(-2.0 * k * k * lambda * lambda);
+        sum += term;
+        if (std::abs(term) < 1e-12) break;
+    }
+    return std::min(1.0, std::max(0.0, sum));
+}
+
+// Chi-square over bins of equal model probability, values must be sorted. p-value from the
+// Wilson-Hilferty normal approximation, good for the bin counts used here.
+template <typename Cdf>
+static double chiSquarePValue(const std::vector<float>& sorted, const Cdf& cdf, int bins, double& statistic) {
+    std::vector<double> counts(bins, 0.0);
+    for (float v : sorted) counts[std::min(bins - 1, (int)(cdf(v) * bins))] += 1.0;
+    const double expected = (double)sorted.size() / bins;
+    statistic = 0.0;
+    for (double c : counts) statistic += (c - expected) * (c - expected) / expected;
+    const double k = bins - 1;
+    double z = (std::cbrt(statistic / k) - (1.0 - 2.0 / (9.0 * k))) / std::sqrt(2.0 / (9.0 * k));
+    return 0.5 * std::erfc(z / std::sqrt(2.0));
+}
+
+// P(chi^2 > statistic) for dof degrees of freedom, exact for the few bins of a share test:
+// Q(1/2, y) = erfc(sqrt y), Q(1, y) = e^-y, Q(s + 1, y) = Q(s, y) + y^s e^-y / Gamma(s + 1)
+static double chiSquareSurvival(double statistic, int dof) {
+    const double y = 0.5 * statistic;
+    double s = dof % 2 ? 0.5 : 1.0;
+    double q = dof % 2 ? std::erfc(std::sqrt(y)) : std::exp(-y);
+    for (; s < 0.5 * dof; s += 1.0) q += std::exp(s * std::log(y) - y - std::lgamma(s + 1.0));
+    return std::min(1.0, q);
+}
+
+struct StateResult {
+    QuantumNumbers qn;
+    size_t points = 0;
+    double sampleMs = 0.0;
+    double tail = 0.0; // probability beyond the sampling radius
+    double ksR = 0.0, ksTheta = 0.0, ksPhi = 0.0;
+    double pR = 1.0, pTheta = 1.0, pPhi = 1.0, pChi = 1.0;
+    double chi = 0.0;
+};
+
+static const int TESTS_PER_STATE = 4;
+static const int CHI_BINS = 64;
+
+// The hybrid coefficients are orthogonal, so the hybrids' densities add up to those of the
+// basis orbitals: the whole cloud has the r and theta marginals of an equal mix of the basis.
+// Each hybrid should hold a 1 / hybrids share of the points.
+struct HybridResult {
+    HybridType type = HybridType::SP;
+    int n = 2;
+    size_t points = 0;
+    double sampleMs = 0.0;
+    double tail = 0.0;
+    double pR = 1.0, pChi = 1.0, pTheta = 1.0, pShare = 1.0;
+};
+
+static HybridResult validateHybrid(HybridType type, int n, int index, const ValidateOptions& options) {
+    HybridResult result;
+    result.type = type;
+    result.n = n;
+    HybridSet set;
+    HybridOrbital::preset(type, n, set);
+    const int hybrids = set.getHybridCount();
+
+    std::vector<glm::vec3> points;
+    std::vector<glm::vec3> colors;
+    auto start = std::chrono::steady_clock::now();
+    HybridOrbital::sample(set, points, colors, options.trials, 1, Random::derive(options.sampler.seed, index));
+    result.sampleMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    result.points = points.size();
+    if (points.empty()) return result;
+
+    std::vector<Hydrogen> basis;
+    for (const RealOrbital& orbital : set.basis) basis.push_back(Hydrogen(n, std::abs(orbital.m), orbital.l, 1));
+    auto radialDensity = [&basis](double r) {
+        double sum = 0.0;
+        for (Hydrogen& h : basis) sum += std::pow(h.getR(r), 2);
+        return r * r * sum / basis.size();
+    };
+    auto polarDensity = [&basis](double theta) {
+        double sum = 0.0;
+        for (Hydrogen& h : basis) sum += std::pow(h.getTheta(theta), 2);
+        return std::sin(theta) * sum / basis.size();
+    };
+    const double maxR = OrbitalGenerator::samplingRadius(QuantumNumbers(n, 0, 0));
+    TabulatedCdf radial(radialDensity, 0.0, maxR);
+    TabulatedCdf polar(polarDensity, 0.0, PI);
+    result.tail = std::max(0.0, 1.0 - radial.getMass());
+
+    std::vector<float> r(points.size()), theta(points.size());
+    std::vector<double> counts(hybrids, 0.0);
+    for (size_t i = 0; i < points.size(); ++i) {
+        glm::dvec3 p(points[i]);
+        r[i] = (float)glm::length(p);
+        theta[i] = r[i] > 0.0f ? (float)std::acos(std::max(-1.0, std::min(1.0, p.z / r[i]))) : 0.0f;
+        for (int h = 0; h < hybrids; ++h) {
+            if (colors[i] == HybridOrbital::hybridColor(h)) counts[h] += 1.0;
+        }
+    }
+
+    double statistic = 0.0;
+    result.pR = ksPValue(ksDistance(r, radial), r.size());
+    result.pChi = chiSquarePValue(r, radial, CHI_BINS, statistic);
+    result.pTheta = ksPValue(ksDistance(theta, polar), theta.size());
+    const double expected = (double)points.size() / hybrids;
+    statistic = 0.0;
+    for (double c : counts) statistic += (c - expected) * (c - expected) / expected;
+    result.pShare = chiSquareSurvival(statistic, hybrids - 1);
+    return result;
+}
+
+static StateResult validateState(const QuantumNumbers& qn, int index, const ValidateOptions& options) {
+    StateResult result;
+    result.qn = qn;
+
+    // independent clouds, +m and -m would otherwise come out identical
+    SamplerOptions sampler = options.sampler;
+    sampler.seed = Random::derive(options.sampler.seed, index);
+    std::vector<glm::vec3> points;
+    std::vector<glm::vec3> colors;
+    auto start = std::chrono::steady_clock::now();
+    OrbitalGenerator::sampleOrbital(qn, points, colors, options.trials, 1, sampler);
+    result.sampleMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    result.points = points.size();
+    if (points.empty()) return result;
+
+    // |psi|^2 r^2 sin(theta) factors into r^2 R^2, sin(theta) Theta^2 and a uniform phi. The
+    // radial model is cut at the sampling radius, the mass beyond it is reported on its own.
+    Hydrogen h(qn.n, qn.m, qn.l, qn.s);
+    const double maxR = OrbitalGenerator::samplingRadius(qn);
+    TabulatedCdf radial([&h](double r) { return r * r * std::pow(h.getR(r), 2); }, 0.0, maxR);
+    TabulatedCdf polar([&h](double theta) { return std::sin(theta) * std::pow(h.getTheta(theta), 2); }, 0.0, PI);
+    result.tail = std::max(0.0, 1.0 - radial.getMass());
+
+    std::vector<float> r(points.size()), theta(points.size()), phi(points.size());
+    for (size_t i = 0; i < points.size(); ++i) {
+        glm::dvec3 p(points[i]);
+        r[i] = (float)glm::length(p);
+        theta[i] = r[i] > 0.0f ? (float)std::acos(std::max(-1.0, std::min(1.0, p.z / r[i]))) : 0.0f;
+        double angle = std::atan2(p.y, p.x);
+        phi[i] = (float)(angle < 0.0 ? angle + 2.0 * PI : angle);
+    }
+
+    result.ksR = ksDistance(r, radial);
+    result.pR = ksPValue(result.ksR, r.size());
+    result.pChi = chiSquarePValue(r, radial, CHI_BINS, result.chi);
+    result.ksTheta = ksDistance(theta, polar);
+    result.pTheta = ksPValue(result.ksTheta, theta.size());
+    result.ksPhi = ksDistance(phi, [](double x) { return std::min(1.0, std::max(0.0, x / (2.0 * PI))); });
+    result.pPhi = ksPValue(result.ksPhi, phi.size());
+    return result;
+}
+
+// Worst error of every VectorMath function and tier over its stated range against libm
+static bool checkVectorMath() {
+    const size_t N = 1 << 20;
+    std::vector<float> x(N), y(N), s(N), c(N);
+    bool ok = true;
+    std::cout << "VectorMath, " << Simd::name() << " x" << VectorMath::getWidth() << "\n";
+    for (MathAccuracy tier : {MathAccuracy::Precise, MathAccuracy::Fast, MathAccuracy::Visual}) {
+        double bound = VectorMath::errorBound(tier);
+        double expError = 0.0, logError = 0.0, sinError = 0.0, cosError = 0.0;
+
+        for (size_t i = 0; i < N; ++i) x[i] = -87.0f + 175.0f * i / N;
+        VectorMath::exp(x.data(), y.data(), N, tier);
+        for (size_t i = 0; i < N; ++i) {
+            double exact = std::exp((double)x[i]);
+            expError = std::max(expError, std::abs(y[i] - exact) / exact);
+        }
+
+        for (size_t i = 0; i < N; ++i) x[i] = std::ldexp(1.0f + (float)i / N, (int)(i % 200) - 100);
+        VectorMath::log(x.data(), y.data(), N, tier);
+        for (size_t i = 0; i < N; ++i) {
+            double exact = std::log((double)x[i]);
+            logError = std::max(logError, std::abs(y[i] - exact) / std::max(1.0, std::abs(exact)));
+        }
+
+        for (size_t i = 0; i < N; ++i) x[i] = -1e4f + 2e4f * i / N;
+        VectorMath::sincos(x.data(), s.data(), c.data(), N, tier);
+        for (size_t i = 0; i < N; ++i) {
+            sinError = std::max(sinError, std::abs(s[i] - std::sin((double)x[i])));
+            cosError = std::max(cosError, std::abs(c[i] - std::cos((double)x[i])));
+        }
+
+        // float itself rounds to 6e-8, a few ulp on top is the precise tier's promise
+        double logBound = tier == MathAccuracy::Precise ? 2e-7 : bound;
+        double relBound = tier == MathAccuracy::Precise ? 2.0 * 1.19e-7 : bound;
+        bool pass = expError <= relBound && logError <= logBound && sinError <= relBound && cosError <= relBound;
+        ok = ok && pass;
+        printf("  %-8s exp %.2e  log %.2e  sin %.2e  cos %.2e  bound %.0e  %s\n", VectorMath::name(tier), expError, logError, sinError,
+               cosError, bound, pass ? "ok" : "FAIL");
+    }
+    return ok;
+}
+
+int main(int argc, char** argv)
+{
+    ValidateOptions options;
+    if (!parseOptions(argc, argv, options)) {
+        printUsage();
+        return 1;
+    }
+
+    bool ok = checkVectorMath();
+
+    const int stateCount = (int)options.states.size();
+    const int hybridCount = (int)options.hybrids.size();
+    const int jobCount = stateCount + hybridCount;
+    int threadCount = options.threads ? options.threads : (int)std::thread::hardware_concurrency();
+    threadCount = std::max(1, std::min(threadCount, jobCount));
+    std::cout << "\nSampler, " << options.trials << " candidates per state, " << threadCount << " threads, seed " << options.sampler.seed << "\n";
+
+    std::vector<StateResult> results(stateCount);
+    std::vector<HybridResult> hybridResults(hybridCount);
+    std::atomic<int> next(0);
+    auto worker = [&]() {
+        int i;
+        while ((i = next++) < jobCount) {
+            if (i < stateCount) {
+                results[i] = validateState(options.states[i], i, options);
+            } else {
+                const auto& hybrid = options.hybrids[i - stateCount];
+                hybridResults[i - stateCount] = validateHybrid(hybrid.first, hybrid.second, i, options);
+            }
+        }
+    };
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int t = 1; t < threadCount; ++t) threads.emplace_back(worker);
+    worker();
+    for (auto& t : threads) t.join();
+    double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // every test of every state and hybrid set shares alpha
+    const double threshold = options.alpha / (jobCount * TESTS_PER_STATE);
+    // FAIL: the cloud does not follow |psi|^2 within the radius, TAIL: the radius cuts off too much
+    printf("  state   points    Mcand/s  p(r KS)   p(r chi2)  p(theta)  p(phi)    tail\n");
+    size_t totalPoints = 0;
+    double totalSampleMs = 0.0;
+    int failures = 0;
+    for (const StateResult& result : results) {
+        bool pass = result.pR >= threshold && result.pChi >= threshold && result.pTheta >= threshold && result.pPhi >= threshold;
+        bool tailOk = result.tail <= options.maxTail;
+        if (!pass || !tailOk) ++failures;
+        totalPoints += result.points;
+        totalSampleMs += result.sampleMs;
+        printf("  %d,%d,%-3d %9zu  %7.2f  %9.2e %9.2e  %9.2e %9.2e %8.1e  %s\n", result.qn.n, result.qn.l, result.qn.m, result.points,
+               options.trials / result.sampleMs / 1e3, result.pR, result.pChi, result.pTheta, result.pPhi, result.tail,
+               !pass ? "FAIL" : tailOk ? "ok" : "TAIL");
+    }
+    if (hybridCount > 0) {
+        printf("\n  hybrid   points    Mcand/s  p(r KS)   p(r chi2)  p(theta)  p(share)  tail\n");
+    }
+    for (const HybridResult& result : hybridResults) {
+        bool pass = result.pR >= threshold && result.pChi >= threshold && result.pTheta >= threshold && result.pShare >= threshold;
+        bool tailOk = result.tail <= options.maxTail;
+        if (!pass || !tailOk) ++failures;
+        totalPoints += result.points;
+        totalSampleMs += result.sampleMs;
+        std::string label = std::string(HybridOrbital::name(result.type)) + "," + std::to_string(result.n);
+        printf("  %-7s %9zu  %7.2f  %9.2e %9.2e  %9.2e %9.2e %8.1e  %s\n", label.c_str(), result.points,
+               options.trials / result.sampleMs / 1e3, result.pR, result.pChi, result.pTheta, result.pShare, result.tail,
+               !pass ? "FAIL" : tailOk ? "ok" : "TAIL");
+    }
+    ok = ok && failures == 0;
+
+    printf("\n%d of %d states and hybrid sets pass at alpha %.2g (per test %.1e)\n", jobCount - failures, jobCount, options.alpha, threshold);
+    printf("Throughput: %.2f M candidates/s and %.2f M points/s per core, %.1f s wall\n",
+           (double)options.trials * jobCount / totalSampleMs / 1e3, totalPoints / totalSampleMs / 1e3, wallSeconds);
+    std::cout << (ok ? "PASS" : "FAIL") << "\n";
+    return ok ? 0 : 1;
+}